@@ -0,0 +1,909 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ *
+ *  referred standards:
+ *    ISO/IEC 13818-1 (2.4.4 PSI sections)
+ *    ETSI EN 300 468 (NIT, SDT, descriptors)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/dvb/frontend.h>
+#include <linux/dvb/dmx.h>
+#include <linux/dvb/version.h>
+
+#include "backend.h"
+#include "crc32.h"
+#include "si_types.h"
+#include "tools.h"
+
+/*
+ * backend_sim: one DVB-C frontend and its demux, tuned to a generated network.
+ *
+ * Nothing ever sleeps: the virtual clock only advances in usleep(), poll() and epoll_wait(),
+ * straight to the next event (lock, section, timer). A scan is therefore deterministic
+ * and the reported scan time is the time the same scan would need on this network.
+ *
+ * Every section of a transponder is sent periodically, with a random phase, from the
+ * virtual time 0 on. A demux filter sees all matching sections arriving after it was started,
+ * if the frontend has lock on their transponder.
+ */
+
+#define SIM_EPOCH     1000 // sec, virtual clock at start.
+#define SIM_FD_BASE   0x4000 // not to be confused with real fds.
+#define SIM_MAX_FD    64
+#define SIM_NETWORK_ID 0x1001
+#define SIM_FREQUENCY  346000000 // first transponder, EU cable channel 26.
+#define SIM_SYMBOLRATE 6900000
+
+static struct {
+    uint32_t tps; // number of transponders.
+    uint32_t services; // per transponder.
+    uint32_t lock; // msec after tuning.
+    uint32_t pat, pmt, nit, sdt; // repetition intervals in msec.
+    uint32_t crc; // percent of sections sent with CRC error.
+    uint32_t seed;
+} sim = { 8, 10, 500, 100, 100, 2000, 1000, 0, 1 };
+
+struct sim_section {
+    uint16_t tp;
+    uint16_t pid;
+    uint16_t len;
+    int64_t interval; // usec
+    int64_t phase; // usec, first arrival.
+    unsigned char *data;
+};
+
+static struct sim_section *sections = NULL;
+static uint32_t n_sections = 0;
+static uint32_t *tp_first = NULL; // sections of transponder i: tp_first[i] .. tp_first[i + 1] - 1
+
+static int64_t now = 0; // usec, virtual clock.
+static uint64_t prng;
+
+enum sim_fd_type { SIM_FD_NONE = 0, SIM_FD_FRONTEND, SIM_FD_DEMUX, SIM_FD_EPOLL, SIM_FD_TIMER };
+
+struct sim_fd {
+    enum sim_fd_type type;
+    // SIM_FD_DEMUX
+    bool started;
+    uint16_t pid;
+    uint8_t filter, mask;
+    int64_t read_time; // arrival of the last section read, or filter start.
+    int32_t read_index; // section index of the last section read, -1 after start.
+    // SIM_FD_EPOLL
+    bool watched[SIM_MAX_FD];
+    epoll_data_t data[SIM_MAX_FD];
+    // SIM_FD_TIMER
+    int64_t deadline; // usec, 0 == disarmed.
+};
+
+static struct sim_fd fds[SIM_MAX_FD];
+
+static struct {
+    fe_delivery_system_t delsys;
+    uint32_t frequency;
+    uint32_t symbolrate;
+    fe_modulation_t modulation;
+    fe_spectral_inversion_t inversion;
+    int tp; // tuned transponder, -1 == none.
+    int64_t tuned; // usec
+    fe_status_t event_status; // status of the last FE_GET_EVENT.
+} fe = { SYS_DVBC_ANNEX_A, 0, 0, QAM_AUTO, INVERSION_AUTO, -1, 0, 0 };
+
+/*******************************************************************************
+ * configuration.
+ ******************************************************************************/
+
+bool
+sim_configure(char const *spec)
+{
+    struct {
+        char const *key;
+        uint32_t *value;
+        uint32_t min, max;
+    } const keys[] = {
+        { "tps", &sim.tps, 1, 64 },          { "services", &sim.services, 1, 32 }, { "lock", &sim.lock, 0, 60000 },
+        { "pat", &sim.pat, 1, 60000 },       { "pmt", &sim.pmt, 1, 60000 },        { "nit", &sim.nit, 1, 60000 },
+        { "sdt", &sim.sdt, 1, 60000 },       { "crc", &sim.crc, 0, 100 },          { "seed", &sim.seed, 0, UINT32_MAX },
+    };
+    char *copy = strdup(spec);
+    char *item, *save = NULL;
+    bool ok = true;
+
+    for (item = strtok_r(copy, ",", &save); item && ok; item = strtok_r(NULL, ",", &save)) {
+        char *value = strchr(item, '=');
+        char *end;
+        unsigned long v;
+        size_t i;
+
+        ok = false;
+        if (value == NULL)
+            break;
+        *value++ = 0;
+        v = strtoul(value, &end, 10);
+        for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+            if (strcmp(item, keys[i].key) == 0) {
+                ok = (*value != 0) && (*end == 0) && (v >= keys[i].min) && (v <= keys[i].max);
+                if (ok)
+                    *keys[i].value = v;
+                break;
+            }
+        }
+        if (!ok)
+            error("--simulate: invalid '%s=%s'\n", item, value);
+    }
+    free(copy);
+    return ok;
+}
+
+/*******************************************************************************
+ * the simulated network: one NIT, PAT, PMTs and SDT per transponder.
+ ******************************************************************************/
+
+/* splitmix64 */
+static uint64_t
+sim_random(void)
+{
+    uint64_t z = (prng += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static unsigned char section[SECTION_BUF_SIZE];
+static int section_len;
+
+static void
+put8(uint8_t v)
+{
+    section[section_len++] = v;
+}
+
+static void
+put16(uint16_t v)
+{
+    put8(v >> 8);
+    put8(v);
+}
+
+static void
+put_text(char const *s)
+{
+    put8(strlen(s));
+    while (*s)
+        put8(*s++);
+}
+
+/* writes a 12bit length field at offset, covering everything behind it. */
+static void
+put_length(int offset, uint8_t reserved)
+{
+    int len = section_len - offset - 2;
+
+    section[offset] = reserved | (len >> 8);
+    section[offset + 1] = len;
+}
+
+static void
+begin_section(uint8_t table_id, uint16_t table_id_ext, uint8_t section_number, uint8_t last_section_number)
+{
+    section_len = 0;
+    put8(table_id);
+    put16(0); // section_syntax_indicator, section_length: see end_section().
+    put16(table_id_ext);
+    put8(0xC1); // version 0, current_next_indicator
+    put8(section_number);
+    put8(last_section_number);
+}
+
+/* adds the section to tp, the sections of one table are sent back to back every interval msec. */
+static void
+end_section(uint16_t tp, uint16_t pid, uint32_t interval, int64_t phase)
+{
+    struct sim_section *s;
+    uint32_t crc;
+
+    section_len += 4;
+    put_length(1, 0xB0);
+    section_len -= 4;
+    crc = crc32_mpeg2(section, section_len);
+    put8(crc >> 24);
+    put8(crc >> 16);
+    put8(crc >> 8);
+    put8(crc);
+
+    if ((sections = realloc(sections, (n_sections + 1) * sizeof(struct sim_section))) == NULL)
+        fatal("%s: out of memory.\n", __FUNCTION__);
+    s = &sections[n_sections++];
+    s->tp = tp;
+    s->pid = pid;
+    s->len = section_len;
+    s->interval = interval * 1000LL;
+    s->phase = (phase + section[6] * 2000LL) % s->interval; // 2 msec between sections of a table.
+    if ((s->data = malloc(section_len)) == NULL)
+        fatal("%s: out of memory.\n", __FUNCTION__);
+    memcpy(s->data, section, section_len);
+}
+
+static uint16_t
+service_id(uint32_t tp, uint32_t n)
+{
+    return (tp + 1) * 100 + n + 1;
+}
+
+/* NIT actual, identical on all transponders; up to 8 transport streams per section. */
+static void
+build_nit(uint32_t tp, int64_t phase)
+{
+    uint32_t first, i, n, last_section = (sim.tps - 1) / 8;
+    int loop;
+
+    for (first = 0; first < sim.tps; first += 8) {
+        begin_section(TABLE_NIT_ACT, SIM_NETWORK_ID, first / 8, last_section);
+        put16(0);
+        put8(0x40); // network_name_descriptor
+        put_text("w_scan2 simulation");
+        put_length(8, 0xF0);
+        loop = section_len;
+        put16(0);
+        for (i = first; (i < sim.tps) && (i < first + 8); i++) {
+            uint32_t f = SIM_FREQUENCY / 100 + i * 80000; // 100Hz units.
+            uint32_t sr = SIM_SYMBOLRATE / 100;
+            int ts_loop;
+
+            put16(i + 1); // transport_stream_id
+            put16(SIM_NETWORK_ID); // original_network_id
+            ts_loop = section_len;
+            put16(0);
+            put8(0x44); // cable_delivery_system_descriptor
+            put8(11);
+            put16(((f / 10000000 % 10) << 12) | ((f / 1000000 % 10) << 8) | ((f / 100000 % 10) << 4) | (f / 10000 % 10));
+            put16(((f / 1000 % 10) << 12) | ((f / 100 % 10) << 8) | ((f / 10 % 10) << 4) | (f % 10));
+            put16(0xFFF2); // FEC_outer: RS(204/188)
+            put8(0x05); // 256 QAM
+            put16(((sr / 1000000 % 10) << 12) | ((sr / 100000 % 10) << 8) | ((sr / 10000 % 10) << 4) | (sr / 1000 % 10));
+            put16(((sr / 100 % 10) << 12) | ((sr / 10 % 10) << 8) | ((sr % 10) << 4) | 0x0F); // FEC_inner: none
+            put8(0x41); // service_list_descriptor
+            put8(3 * sim.services);
+            for (n = 0; n < sim.services; n++) {
+                put16(service_id(i, n));
+                put8(0x01); // digital television service
+            }
+            put_length(ts_loop, 0xF0);
+        }
+        put_length(loop, 0xF0);
+        end_section(tp, PID_NIT_ST, sim.nit, phase);
+    }
+}
+
+static void
+build_network(void)
+{
+    uint32_t tp, n;
+    char name[32];
+
+    prng = sim.seed;
+    if ((tp_first = calloc(sim.tps + 1, sizeof(uint32_t))) == NULL)
+        fatal("%s: out of memory.\n", __FUNCTION__);
+
+    for (tp = 0; tp < sim.tps; tp++) {
+        tp_first[tp] = n_sections;
+
+        begin_section(TABLE_PAT, tp + 1, 0, 0);
+        put16(0);
+        put16(0xE000 | PID_NIT_ST);
+        for (n = 0; n < sim.services; n++) {
+            put16(service_id(tp, n));
+            put16(0xE000 | (0x100 + n));
+        }
+        end_section(tp, PID_PAT, sim.pat, sim_random() % (sim.pat * 1000));
+
+        for (n = 0; n < sim.services; n++) {
+            begin_section(TABLE_PMT, service_id(tp, n), 0, 0);
+            put16(0xE000 | (0x200 + n)); // PCR_PID
+            put16(0xF000);
+            put8(0x02); // MPEG-2 video
+            put16(0xE000 | (0x200 + n));
+            put16(0xF000);
+            put8(0x03); // MPEG-1 audio
+            put16(0xE000 | (0x300 + n));
+            put16(0xF006);
+            put8(0x0A); // ISO_639_language_descriptor
+            put8(4);
+            put8('d');
+            put8('e');
+            put8('u');
+            put8(0); // audio_type: undefined
+            end_section(tp, 0x100 + n, sim.pmt, sim_random() % (sim.pmt * 1000));
+        }
+
+        build_nit(tp, sim_random() % (sim.nit * 1000));
+
+        begin_section(TABLE_SDT_ACT, tp + 1, 0, 0);
+        put16(SIM_NETWORK_ID);
+        put8(0xFF);
+        for (n = 0; n < sim.services; n++) {
+            int loop;
+
+            snprintf(name, sizeof(name), "Sim %u-%u", tp + 1, n + 1);
+            put16(service_id(tp, n));
+            put8(0xFC);
+            loop = section_len;
+            put16(0);
+            put8(0x48); // service_descriptor
+            put8(3 + strlen("w_scan2") + strlen(name));
+            put8(0x01);
+            put_text("w_scan2");
+            put_text(name);
+            put_length(loop, 0x80); // running
+        }
+        end_section(tp, PID_SDT_BAT_ST, sim.sdt, sim_random() % (sim.sdt * 1000));
+    }
+    tp_first[tp] = n_sections;
+    verbose("simulating %u transponders from %u kHz with %u services each, %u sections.\n", sim.tps, SIM_FREQUENCY / 1000,
+            sim.services, n_sections);
+}
+
+/*******************************************************************************
+ * frontend.
+ ******************************************************************************/
+
+static void
+sim_tune(void)
+{
+    uint32_t i;
+
+    fe.tp = -1;
+    fe.tuned = now;
+    fe.event_status = 0;
+    if ((fe.delsys != SYS_DVBC_ANNEX_A) || ((fe.modulation != QAM_AUTO) && (fe.modulation != QAM_256)))
+        return;
+    for (i = 0; i < sim.tps; i++) {
+        uint32_t f = SIM_FREQUENCY + i * 8000000;
+
+        // within 1MHz and 0.1% of the symbol rate.
+        if ((fe.frequency + 1000000 >= f) && (fe.frequency <= f + 1000000) &&
+            (fe.symbolrate + SIM_SYMBOLRATE / 1000 >= SIM_SYMBOLRATE) && (fe.symbolrate <= SIM_SYMBOLRATE + SIM_SYMBOLRATE / 1000)) {
+            fe.tp = i;
+            break;
+        }
+    }
+}
+
+/* signal and carrier after half of the lock time. */
+static fe_status_t
+sim_status(void)
+{
+    if (fe.tp < 0)
+        return 0;
+    if (now - fe.tuned >= sim.lock * 1000LL)
+        return FE_HAS_SIGNAL | FE_HAS_CARRIER | FE_HAS_VITERBI | FE_HAS_SYNC | FE_HAS_LOCK;
+    if (now - fe.tuned >= sim.lock * 500LL)
+        return FE_HAS_SIGNAL | FE_HAS_CARRIER;
+    return 0;
+}
+
+/* time of the next status change, -1 if none. */
+static int64_t
+sim_status_change(void)
+{
+    if (fe.tp < 0)
+        return -1;
+    if (now - fe.tuned < sim.lock * 500LL)
+        return fe.tuned + sim.lock * 500LL;
+    if (now - fe.tuned < sim.lock * 1000LL)
+        return fe.tuned + sim.lock * 1000LL;
+    return -1;
+}
+
+static int
+frontend_ioctl(unsigned long request, void *arg)
+{
+    struct dtv_properties *cmdseq = arg;
+    uint32_t i;
+
+    switch (request) {
+    case FE_GET_INFO: {
+        struct dvb_frontend_info *info = arg;
+
+        memset(info, 0, sizeof(*info));
+        snprintf(info->name, sizeof(info->name), "w_scan2 simulated DVB-C");
+        info->type = FE_QAM;
+        info->frequency_min = 47000000;
+        info->frequency_max = 862000000;
+        info->frequency_stepsize = 62500;
+        info->symbol_rate_min = 870000;
+        info->symbol_rate_max = 7200000;
+        info->caps =
+            FE_CAN_INVERSION_AUTO | FE_CAN_FEC_AUTO | FE_CAN_QAM_64 | FE_CAN_QAM_128 | FE_CAN_QAM_256 | FE_CAN_QAM_AUTO;
+        return 0;
+    }
+    case FE_GET_PROPERTY:
+        for (i = 0; i < cmdseq->num; i++) {
+            struct dtv_property *p = &cmdseq->props[i];
+
+            switch (p->cmd) {
+            case DTV_API_VERSION:
+                p->u.data = (DVB_API_VERSION << 8) | DVB_API_VERSION_MINOR;
+                break;
+            case DTV_ENUM_DELSYS:
+                p->u.buffer.data[0] = SYS_DVBC_ANNEX_A;
+                p->u.buffer.len = 1;
+                break;
+            case DTV_DELIVERY_SYSTEM:
+                p->u.data = fe.delsys;
+                break;
+            case DTV_FREQUENCY:
+                p->u.data = fe.frequency;
+                break;
+            case DTV_SYMBOL_RATE:
+                p->u.data = fe.symbolrate;
+                break;
+            case DTV_MODULATION:
+                p->u.data = fe.tp < 0 ? fe.modulation : QAM_256;
+                break;
+            case DTV_INVERSION:
+                p->u.data = fe.tp < 0 ? fe.inversion : INVERSION_OFF;
+                break;
+            default:
+                p->u.data = 0;
+            }
+        }
+        return 0;
+    case FE_SET_PROPERTY:
+        for (i = 0; i < cmdseq->num; i++) {
+            struct dtv_property *p = &cmdseq->props[i];
+
+            switch (p->cmd) {
+            case DTV_DELIVERY_SYSTEM:
+                if (p->u.data != SYS_DVBC_ANNEX_A) {
+                    errno = EINVAL;
+                    return -1;
+                }
+                fe.delsys = p->u.data;
+                break;
+            case DTV_FREQUENCY:
+                fe.frequency = p->u.data;
+                break;
+            case DTV_SYMBOL_RATE:
+                fe.symbolrate = p->u.data;
+                break;
+            case DTV_MODULATION:
+                fe.modulation = p->u.data;
+                break;
+            case DTV_INVERSION:
+                fe.inversion = p->u.data;
+                break;
+            case DTV_TUNE:
+                sim_tune();
+                break;
+            default:;
+            }
+        }
+        return 0;
+    case FE_READ_STATUS:
+        *(fe_status_t *)arg = sim_status();
+        return 0;
+    case FE_READ_SIGNAL_STRENGTH:
+        *(uint16_t *)arg = sim_status() & FE_HAS_SIGNAL ? 0xC000 : 0;
+        return 0;
+    case FE_READ_SNR:
+        *(uint16_t *)arg = sim_status() & FE_HAS_LOCK ? 0x9000 : 0;
+        return 0;
+    case FE_READ_BER:
+    case FE_READ_UNCORRECTED_BLOCKS:
+        *(uint32_t *)arg = 0;
+        return 0;
+    case FE_GET_EVENT: {
+        struct dvb_frontend_event *event = arg;
+
+        if (sim_status() == fe.event_status) {
+            errno = EWOULDBLOCK;
+            return -1;
+        }
+        memset(event, 0, sizeof(*event));
+        event->status = fe.event_status = sim_status();
+        return 0;
+    }
+    default:
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+}
+
+/*******************************************************************************
+ * demux.
+ ******************************************************************************/
+
+static bool
+sim_matches(struct sim_fd *d, struct sim_section *s)
+{
+    return d->started && (s->pid == d->pid) && ((s->data[0] & d->mask) == (d->filter & d->mask));
+}
+
+/* next arrival of a section for demux d after its last read, -1 if none.
+ * Sections are only received with lock, ties between sections are broken by their index.
+ */
+static int64_t
+sim_next_section(struct sim_fd *d, uint32_t *index)
+{
+    int64_t best = -1, from;
+    uint32_t i;
+
+    if (!d->started || (fe.tp < 0))
+        return -1;
+    from = fe.tuned + sim.lock * 1000LL;
+    if (from < d->read_time)
+        from = d->read_time;
+
+    for (i = tp_first[fe.tp]; i < tp_first[fe.tp + 1]; i++) {
+        struct sim_section *s = &sections[i];
+        int64_t t;
+
+        if (!sim_matches(d, s))
+            continue;
+        t = s->phase;
+        if (t < from)
+            t += (from - t + s->interval - 1) / s->interval * s->interval;
+        if ((t == d->read_time) && ((int32_t)i <= d->read_index))
+            t += s->interval;
+        if ((best < 0) || (t < best) || ((t == best) && (i < *index))) {
+            best = t;
+            *index = i;
+        }
+    }
+    return best;
+}
+
+static int
+demux_ioctl(struct sim_fd *d, unsigned long request, void *arg)
+{
+    switch (request) {
+    case DMX_SET_BUFFER_SIZE:
+        return 0;
+    case DMX_SET_FILTER: {
+        struct dmx_sct_filter_params *f = arg;
+
+        d->pid = f->pid;
+        d->filter = f->filter.filter[0];
+        d->mask = f->filter.mask[0];
+        d->started = f->flags & DMX_IMMEDIATE_START;
+        d->read_time = now;
+        d->read_index = -1;
+        return 0;
+    }
+    case DMX_START:
+        d->started = true;
+        d->read_time = now;
+        d->read_index = -1;
+        return 0;
+    case DMX_STOP:
+        d->started = false;
+        return 0;
+    default: // no PES/TS filters, i.e. no --userspace-demux.
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+static ssize_t
+demux_read(struct sim_fd *d, void *buf, size_t count)
+{
+    uint32_t index = 0;
+    int64_t t = sim_next_section(d, &index);
+    struct sim_section *s = &sections[index];
+
+    if ((t < 0) || (t > now)) {
+        errno = EAGAIN;
+        return -1;
+    }
+    d->read_time = t;
+    d->read_index = index;
+    if (count < s->len) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    memcpy(buf, s->data, s->len);
+    if (sim.crc > 0) {
+        // same decision for each repetition of a section, independent of the scan.
+        uint64_t saved = prng;
+
+        prng = ((uint64_t)sim.seed << 32) ^ ((uint64_t)index << 24) ^ (uint64_t)((t - s->phase) / s->interval);
+        if (sim_random() % 100 < sim.crc)
+            ((unsigned char *)buf)[s->len - 1] ^= 0x01;
+        prng = saved;
+    }
+    return s->len;
+}
+
+/*******************************************************************************
+ * file descriptors and virtual clock.
+ ******************************************************************************/
+
+static struct sim_fd *
+sim_lookup(int fd, enum sim_fd_type type)
+{
+    if ((fd < SIM_FD_BASE) || (fd >= SIM_FD_BASE + SIM_MAX_FD) || (fds[fd - SIM_FD_BASE].type == SIM_FD_NONE) ||
+        ((type != SIM_FD_NONE) && (fds[fd - SIM_FD_BASE].type != type))) {
+        errno = EBADF;
+        return NULL;
+    }
+    return &fds[fd - SIM_FD_BASE];
+}
+
+static int
+sim_alloc_fd(enum sim_fd_type type)
+{
+    int i;
+
+    if (sections == NULL)
+        build_network();
+    for (i = 0; i < SIM_MAX_FD; i++) {
+        if (fds[i].type == SIM_FD_NONE) {
+            memset(&fds[i], 0, sizeof(fds[i]));
+            fds[i].type = type;
+            return SIM_FD_BASE + i;
+        }
+    }
+    errno = EMFILE;
+    return -1;
+}
+
+/* time, at which fd becomes readable; now if it is, -1 if never. */
+static int64_t
+sim_ready(int fd, short events)
+{
+    struct sim_fd *f = sim_lookup(fd, SIM_FD_NONE);
+    uint32_t index = 0;
+    int64_t t;
+
+    if (f == NULL)
+        return -1;
+    switch (f->type) {
+    case SIM_FD_FRONTEND:
+        if ((events & POLLPRI) == 0)
+            return -1;
+        if (sim_status() != fe.event_status)
+            return now;
+        return sim_status_change();
+    case SIM_FD_DEMUX:
+        t = sim_next_section(f, &index);
+        return (t < 0) || (t > now) ? t : now;
+    case SIM_FD_TIMER:
+        if (f->deadline == 0)
+            return -1;
+        return f->deadline > now ? f->deadline : now;
+    default:
+        return -1;
+    }
+}
+
+static int
+sim_open(char const *pathname, int flags)
+{
+    if (strcmp(pathname, "/dev/dvb/adapter0/frontend0") == 0)
+        return sim_alloc_fd(SIM_FD_FRONTEND);
+    if (strcmp(pathname, "/dev/dvb/adapter0/demux0") == 0)
+        return sim_alloc_fd(SIM_FD_DEMUX);
+    errno = ENOENT;
+    return -1;
+}
+
+static int
+sim_close(int fd)
+{
+    int i;
+
+    if (sim_lookup(fd, SIM_FD_NONE) == NULL)
+        return -1;
+    fds[fd - SIM_FD_BASE].type = SIM_FD_NONE;
+    for (i = 0; i < SIM_MAX_FD; i++) {
+        if (fds[i].type == SIM_FD_EPOLL)
+            fds[i].watched[fd - SIM_FD_BASE] = false;
+    }
+    return 0;
+}
+
+static int
+sim_ioctl(int fd, unsigned long request, ...)
+{
+    struct sim_fd *f = sim_lookup(fd, SIM_FD_NONE);
+    va_list args;
+    void *arg;
+
+    va_start(args, request);
+    arg = va_arg(args, void *);
+    va_end(args);
+    if (f == NULL)
+        return -1;
+    if (f->type == SIM_FD_FRONTEND)
+        return frontend_ioctl(request, arg);
+    if (f->type == SIM_FD_DEMUX)
+        return demux_ioctl(f, request, arg);
+    errno = ENOTTY;
+    return -1;
+}
+
+static ssize_t
+sim_read(int fd, void *buf, size_t count)
+{
+    struct sim_fd *f = sim_lookup(fd, SIM_FD_NONE);
+
+    if (f == NULL)
+        return -1;
+    if (f->type == SIM_FD_DEMUX)
+        return demux_read(f, buf, count);
+    if ((f->type == SIM_FD_TIMER) && f->deadline && (f->deadline <= now) && (count >= sizeof(uint64_t))) {
+        *(uint64_t *)buf = 1;
+        f->deadline = 0;
+        return sizeof(uint64_t);
+    }
+    errno = EAGAIN;
+    return -1;
+}
+
+/* advances the clock to the earliest of the times, but not beyond timeout msec. */
+static void
+sim_advance(int64_t next, int timeout)
+{
+    if ((timeout >= 0) && ((next < 0) || (next > now + timeout * 1000LL)))
+        next = now + timeout * 1000LL;
+    if (next > now)
+        now = next;
+}
+
+static int
+sim_poll(struct pollfd *pfds, nfds_t nfds, int timeout)
+{
+    int64_t next = -1;
+    nfds_t i;
+    int n = 0;
+
+    for (i = 0; i < nfds; i++) {
+        int64_t t = sim_ready(pfds[i].fd, pfds[i].events);
+
+        if ((t >= 0) && ((next < 0) || (t < next)))
+            next = t;
+    }
+    if ((next < 0) && (timeout < 0))
+        return 0; // would block forever.
+    sim_advance(next, timeout);
+    for (i = 0; i < nfds; i++) {
+        pfds[i].revents = sim_ready(pfds[i].fd, pfds[i].events) == now ? pfds[i].events & (POLLIN | POLLPRI) : 0;
+        n += pfds[i].revents != 0;
+    }
+    return n;
+}
+
+static int
+sim_epoll_create1(int flags)
+{
+    return sim_alloc_fd(SIM_FD_EPOLL);
+}
+
+static int
+sim_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    struct sim_fd *e = sim_lookup(epfd, SIM_FD_EPOLL);
+
+    if ((e == NULL) || (sim_lookup(fd, SIM_FD_NONE) == NULL))
+        return -1;
+    switch (op) {
+    case EPOLL_CTL_ADD:
+    case EPOLL_CTL_MOD:
+        e->watched[fd - SIM_FD_BASE] = true;
+        e->data[fd - SIM_FD_BASE] = event->data;
+        return 0;
+    case EPOLL_CTL_DEL:
+        e->watched[fd - SIM_FD_BASE] = false;
+        return 0;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+static int
+sim_epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+    struct sim_fd *e = sim_lookup(epfd, SIM_FD_EPOLL);
+    int64_t next = -1;
+    int i, n = 0;
+
+    if (e == NULL)
+        return -1;
+    for (i = 0; i < SIM_MAX_FD; i++) {
+        int64_t t = e->watched[i] ? sim_ready(SIM_FD_BASE + i, POLLIN) : -1;
+
+        if ((t >= 0) && ((next < 0) || (t < next)))
+            next = t;
+    }
+    if ((next < 0) && (timeout < 0))
+        return 0; // would block forever.
+    sim_advance(next, timeout);
+    for (i = 0; (i < SIM_MAX_FD) && (n < maxevents); i++) {
+        if (e->watched[i] && (sim_ready(SIM_FD_BASE + i, POLLIN) == now)) {
+            events[n].events = EPOLLIN;
+            events[n].data = e->data[i];
+            n++;
+        }
+    }
+    return n;
+}
+
+static int
+sim_timerfd_create(int clockid, int flags)
+{
+    return sim_alloc_fd(SIM_FD_TIMER);
+}
+
+static int
+sim_timerfd_settime(int fd, int flags, struct itimerspec const *new_value, struct itimerspec *old_value)
+{
+    struct sim_fd *f = sim_lookup(fd, SIM_FD_TIMER);
+    int64_t t = new_value->it_value.tv_sec * 1000000LL + new_value->it_value.tv_nsec / 1000;
+
+    if (f == NULL)
+        return -1;
+    if (t == 0)
+        f->deadline = 0;
+    else if (flags & TFD_TIMER_ABSTIME)
+        f->deadline = t - SIM_EPOCH * 1000000LL;
+    else
+        f->deadline = now + t;
+    return 0;
+}
+
+static int
+sim_clock_gettime(clockid_t clockid, struct timespec *tp)
+{
+    tp->tv_sec = SIM_EPOCH + now / 1000000;
+    tp->tv_nsec = (now % 1000000) * 1000;
+    return 0;
+}
+
+static int
+sim_usleep(useconds_t usec)
+{
+    now += usec;
+    return 0;
+}
+
+struct backend const backend_sim = {
+    .name = "simulation",
+    .open = sim_open,
+    .close = sim_close,
+    .ioctl = sim_ioctl,
+    .read = sim_read,
+    .poll = sim_poll,
+    .epoll_create1 = sim_epoll_create1,
+    .epoll_ctl = sim_epoll_ctl,
+    .epoll_wait = sim_epoll_wait,
+    .timerfd_create = sim_timerfd_create,
+    .timerfd_settime = sim_timerfd_settime,
+    .clock_gettime = sim_clock_gettime,
+    .usleep = sim_usleep,
+};
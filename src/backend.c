@@ -0,0 +1,67 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "backend.h"
+
+/*
+ * linux dvb devices: ioctl() and open() are variadic, everything else is passed as is.
+ */
+
+static int
+dvb_open(char const *pathname, int flags)
+{
+    return open(pathname, flags);
+}
+
+static int
+dvb_ioctl(int fd, unsigned long request, ...)
+{
+    va_list args;
+    void *arg;
+
+    va_start(args, request);
+    arg = va_arg(args, void *);
+    va_end(args);
+    return ioctl(fd, request, arg);
+}
+
+struct backend const backend_dvb = {
+    .name = "dvb",
+    .open = dvb_open,
+    .close = close,
+    .ioctl = dvb_ioctl,
+    .read = read,
+    .poll = poll,
+    .epoll_create1 = epoll_create1,
+    .epoll_ctl = epoll_ctl,
+    .epoll_wait = epoll_wait,
+    .timerfd_create = timerfd_create,
+    .timerfd_settime = timerfd_settime,
+    .clock_gettime = clock_gettime,
+    .usleep = usleep,
+};
+
+struct backend const *backend = &backend_dvb;
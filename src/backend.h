@@ -0,0 +1,67 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#ifndef __BACKEND_H__
+#define __BACKEND_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+/*
+ * device access of the scan: frontend and demux file descriptors, waiting for them
+ * and the clock used for all tuning and filter timeouts. Same semantics as the
+ * system calls of the same names.
+ *
+ *   backend_dvb: the linux dvb devices, i.e. the plain system calls.
+ *   backend_sim: a simulated DVB-C network running on a virtual clock, see sim_configure().
+ */
+struct backend {
+    char const *name;
+    int (*open)(char const *pathname, int flags);
+    int (*close)(int fd);
+    int (*ioctl)(int fd, unsigned long request, ...); // one optional argument, as in ioctl(2).
+    ssize_t (*read)(int fd, void *buf, size_t count);
+    int (*poll)(struct pollfd *fds, nfds_t nfds, int timeout);
+    int (*epoll_create1)(int flags);
+    int (*epoll_ctl)(int epfd, int op, int fd, struct epoll_event *event);
+    int (*epoll_wait)(int epfd, struct epoll_event *events, int maxevents, int timeout);
+    int (*timerfd_create)(int clockid, int flags);
+    int (*timerfd_settime)(int fd, int flags, struct itimerspec const *new_value, struct itimerspec *old_value);
+    int (*clock_gettime)(clockid_t clockid, struct timespec *tp);
+    int (*usleep)(useconds_t usec);
+};
+
+extern struct backend const backend_dvb;
+extern struct backend const backend_sim;
+extern struct backend const *backend; // backend_dvb, unless --simulate.
+
+/*
+ * configures backend_sim from a comma separated list of key=value, e.g. "tps=8,lock=300,crc=2".
+ * returns false on unknown keys or invalid values.
+ */
+bool sim_configure(char const *spec);
+
+#endif
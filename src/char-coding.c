@@ -40,6 +40,178 @@
 #define MIN(X, Y) (X < Y ? X : Y)
 #define IsCharacterCodingCode(C) (C < 0x20)
 
+/* iconv_open() is expensive: conversion descriptors are opened once
+ * per (dvb charset, user charset) and kept for the whole run.
+ */
+struct conversion {
+    unsigned from;
+    unsigned to;
+    iconv_t cd;
+    bool ascii; // printable 7bit ASCII (0x20..0x7E) is the same in both charsets.
+};
+
+static struct conversion *conversions = NULL;
+static unsigned conversions_count = 0;
+
+static bool
+is_printable_ascii(char const *buf, size_t len)
+{
+    while (len--) {
+        if ((*buf < 0x20) || (*buf > 0x7E))
+            return false;
+        buf++;
+    }
+    return true;
+}
+
+/* returns NULL and errno from iconv_open() on failure. */
+static struct conversion *
+get_conversion(unsigned from, unsigned to)
+{
+    struct conversion *c;
+    char *usr;
+    iconv_t cd;
+    unsigned i;
+
+    for (i = 0; i < conversions_count; i++) {
+        if ((conversions[i].from == from) && (conversions[i].to == to))
+            return &conversions[i];
+    }
+
+    usr = calloc(strlen(iconv_codes[to]) + strlen("//IGNORE") + 1, 1);
+    strcpy(usr, iconv_codes[to]);
+    strcpy(&usr[strlen(iconv_codes[to])], "//IGNORE");
+    cd = iconv_open((char const *)usr, iconv_codes[from]);
+    free(usr);
+    if (cd == (iconv_t)(-1))
+        return NULL;
+
+    conversions = realloc(conversions, (conversions_count + 1) * sizeof(struct conversion));
+    c = &conversions[conversions_count++];
+    c->from = from;
+    c->to = to;
+    c->cd = cd;
+    {
+        char ascii[0x7F - 0x20], out[4 * sizeof(ascii)];
+        char *pin = ascii, *pout = out;
+        size_t nin = sizeof(ascii), nout = sizeof(out);
+
+        for (i = 0; i < sizeof(ascii); i++)
+            ascii[i] = 0x20 + i;
+        c->ascii = (iconv(cd, &pin, &nin, &pout, &nout) != (size_t)(-1)) && (nin == 0) &&
+            (pout - out == (int)sizeof(ascii)) && !memcmp(ascii, out, sizeof(ascii));
+    }
+    return c;
+}
+
+/* ISO/IEC 6937 to UTF-8 w/o iconv, for the default fallback charset ISO69372.
+ * Same mapping as iconv's ISO_6937-2, except 0xA4, which is the euro sign in DVB.
+ * Bytes w/o mapping are skipped, as by iconv with //IGNORE.
+ */
+#define UTF8_CHARSET_ID 0 // iconv_codes[0], "UTF-8"
+
+static uint16_t const iso6937_upper[96] = {
+    0x0000, 0x00A1, 0x00A2, 0x00A3, 0x20AC, 0x00A5, 0x0023, 0x00A7, // 0xA0
+    0x00A4, 0x2018, 0x201C, 0x00AB, 0x2190, 0x2191, 0x2192, 0x2193, // 0xA8
+    0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00D7, 0x00B5, 0x00B6, 0x00B7, // 0xB0
+    0x00F7, 0x2019, 0x201D, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF, // 0xB8
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, // 0xC0, 0xC1..0xCF: diacritics
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, // 0xC8
+    0x2014, 0x00B9, 0x00AE, 0x00A9, 0x2122, 0x266A, 0x0000, 0x0000, // 0xD0
+    0x0000, 0x0000, 0x0000, 0x0000, 0x215B, 0x215C, 0x215D, 0x215E, // 0xD8
+    0x2126, 0x00C6, 0x00D0, 0x00AA, 0x0126, 0x0000, 0x0132, 0x013F, // 0xE0
+    0x0141, 0x00D8, 0x0152, 0x00BA, 0x00DE, 0x0166, 0x014A, 0x0149, // 0xE8
+    0x0138, 0x00E6, 0x0111, 0x00F0, 0x0127, 0x0131, 0x0133, 0x0140, // 0xF0
+    0x0142, 0x00F8, 0x0153, 0x00DF, 0x00FE, 0x0167, 0x014B, 0x0000, // 0xF8
+};
+
+/* non-spacing diacritical marks 0xC1..0xCF, followed by the base character. */
+struct diacritic {
+    char const *base;
+    uint16_t const ucs[25];
+};
+
+static struct diacritic const iso6937_diacritics[15] = {
+    { "AEIOUaeiou", // 0xC1 grave
+      { 0x00C0, 0x00C8, 0x00CC, 0x00D2, 0x00D9, 0x00E0, 0x00E8, 0x00EC, 0x00F2, 0x00F9 } },
+    { " ACEILNORSUYZaceilnorsuyz", // 0xC2 acute
+      { 0x00B4, 0x00C1, 0x0106, 0x00C9, 0x00CD, 0x0139, 0x0143, 0x00D3, 0x0154, 0x015A, 0x00DA, 0x00DD, 0x0179,
+        0x00E1, 0x0107, 0x00E9, 0x00ED, 0x013A, 0x0144, 0x00F3, 0x0155, 0x015B, 0x00FA, 0x00FD, 0x017A } },
+    { "ACEGHIJOSUWYaceghijosuwy", // 0xC3 circumflex
+      { 0x00C2, 0x0108, 0x00CA, 0x011C, 0x0124, 0x00CE, 0x0134, 0x00D4, 0x015C, 0x00DB, 0x0174, 0x0176,
+        0x00E2, 0x0109, 0x00EA, 0x011D, 0x0125, 0x00EE, 0x0135, 0x00F4, 0x015D, 0x00FB, 0x0175, 0x0177 } },
+    { " AINOUainou", // 0xC4 tilde
+      { 0x007E, 0x00C3, 0x0128, 0x00D1, 0x00D5, 0x0168, 0x00E3, 0x0129, 0x00F1, 0x00F5, 0x0169 } },
+    { " AEIOUaeiou", // 0xC5 macron
+      { 0x00AF, 0x0100, 0x0112, 0x012A, 0x014C, 0x016A, 0x0101, 0x0113, 0x012B, 0x014D, 0x016B } },
+    { " AGUagu", // 0xC6 breve
+      { 0x02D8, 0x0102, 0x011E, 0x016C, 0x0103, 0x011F, 0x016D } },
+    { " CEGIZcegz", // 0xC7 dot
+      { 0x02D9, 0x010A, 0x0116, 0x0120, 0x0130, 0x017B, 0x010B, 0x0117, 0x0121, 0x017C } },
+    { " AEIOUYaeiouy", // 0xC8 diaeresis
+      { 0x00A8, 0x00C4, 0x00CB, 0x00CF, 0x00D6, 0x00DC, 0x0178, 0x00E4, 0x00EB, 0x00EF, 0x00F6, 0x00FC, 0x00FF } },
+    { "", { 0 } }, // 0xC9 reserved
+    { " AUau", // 0xCA ring
+      { 0x02DA, 0x00C5, 0x016E, 0x00E5, 0x016F } },
+    { " CGKLNRSTcgklnrst", // 0xCB cedilla
+      { 0x00B8, 0x00C7, 0x0122, 0x0136, 0x013B, 0x0145, 0x0156, 0x015E, 0x0162,
+        0x00E7, 0x0123, 0x0137, 0x013C, 0x0146, 0x0157, 0x015F, 0x0163 } },
+    { "", { 0 } }, // 0xCC reserved
+    { " OUou", // 0xCD double acute
+      { 0x02DD, 0x0150, 0x0170, 0x0151, 0x0171 } },
+    { " AEIUaeiu", // 0xCE ogonek
+      { 0x02DB, 0x0104, 0x0118, 0x012E, 0x0172, 0x0105, 0x0119, 0x012F, 0x0173 } },
+    { " CDELNRSTZcdelnrstz", // 0xCF caron
+      { 0x02C7, 0x010C, 0x010E, 0x011A, 0x013D, 0x0147, 0x0158, 0x0160, 0x0164, 0x017D,
+        0x010D, 0x010F, 0x011B, 0x013E, 0x0148, 0x0159, 0x0161, 0x0165, 0x017E } },
+};
+
+static void
+iso6937_to_utf8(char **inbuf, size_t *inbytesleft, char **outbuf, size_t *outbytesleft)
+{
+    unsigned char const *in = (unsigned char const *)*inbuf;
+    unsigned char const *end = in + *inbytesleft;
+    unsigned char *out = (unsigned char *)*outbuf;
+
+    while (in < end) {
+        unsigned char c = *in++;
+        uint16_t ucs;
+
+        if (c < 0xA0)
+            ucs = c == 0x24 ? 0x00A4 : c;
+        else if ((c >= 0xC1) && (c <= 0xCF)) {
+            struct diacritic const *d = &iso6937_diacritics[c - 0xC1];
+            char const *p;
+
+            if (in == end)
+                break; // incomplete.
+            if ((*in < 0x20) || (*in > 0x7F))
+                continue; // skip the diacritical mark only.
+            p = strchr(d->base, *in++);
+            ucs = p ? d->ucs[p - d->base] : 0;
+        } else
+            ucs = iso6937_upper[c - 0xA0];
+
+        if ((ucs == 0) && (c != 0))
+            continue;
+        if (ucs < 0x80)
+            *out++ = ucs;
+        else if (ucs < 0x800) {
+            *out++ = 0xC0 | (ucs >> 6);
+            *out++ = 0x80 | (ucs & 0x3F);
+        } else {
+            *out++ = 0xE0 | (ucs >> 12);
+            *out++ = 0x80 | ((ucs >> 6) & 0x3F);
+            *out++ = 0x80 | (ucs & 0x3F);
+        }
+    }
+    *out = 0;
+    *outbytesleft -= (char *)out - *outbuf;
+    *outbuf = (char *)out;
+    *inbuf = (char *)end;
+    *inbytesleft = 0;
+}
+
 /*
  * handle character set correctly (via glib iconv),
  * ISO/EN 300 468 annex A
@@ -231,6 +403,10 @@ char_coding(
     if (dvb_charset_id > iconv_codes_count()) {
         // no special character coding applied: use a fallback one.
         DVBCHARSET(fallback_input_charset);
+        if ((strcmp(fallback_input_charset, "ISO69372") == 0) && (user_charset_id == UTF8_CHARSET_ID)) {
+            iso6937_to_utf8(inbuf, inbytesleft, outbuf, outbytesleft);
+            return;
+        }
         if (strcmp(fallback_input_charset, "ISO69372") == 0) {
             char *pEuro;
             while (**inbuf && (pEuro = strchr(*inbuf, 0xA4))) {
@@ -275,17 +451,9 @@ char_coding(
         return;
 
     if (user_charset_id < iconv_codes_count()) {
-        char *usr = calloc(strlen(iconv_codes[user_charset_id]) + strlen("//IGNORE") + 1, 1);
-        iconv_t conversion_descriptor;
-
-        strcpy(usr, iconv_codes[user_charset_id]);
-        strcpy(&usr[strlen(iconv_codes[user_charset_id])], "//IGNORE");
+        struct conversion *c = get_conversion(dvb_charset_id, user_charset_id);
 
-        // debug("\t\t%s: converting '%s' from '%s' to '%s'\n", __FUNCTION__, *inbuf, iconv_codes[dvb_charset_id], usr);
-        conversion_descriptor = iconv_open((char const *)usr, iconv_codes[dvb_charset_id]);
-        free(usr);
-
-        if (conversion_descriptor == (iconv_t)(-1)) {
+        if (c == NULL) {
             warning("\t\t%s %d: iconv_open failed.\n", __FUNCTION__, __LINE__);
             switch (errno) {
             case EINVAL:
@@ -298,8 +466,20 @@ char_coding(
                 info("\t\t%s\n", strerror(errno));
             }
             err++;
+        } else if (c->ascii && is_printable_ascii(*inbuf, *inbytesleft)) {
+            // nothing to convert.
+            memcpy(*outbuf, *inbuf, *inbytesleft);
+            *outbuf += *inbytesleft;
+            *outbytesleft -= *inbytesleft;
+            *inbuf += *inbytesleft;
+            *inbytesleft = 0;
+            **outbuf = 0;
+            return;
         } else {
-            size_t result = iconv(conversion_descriptor, inbuf, inbytesleft, outbuf, outbytesleft);
+            size_t result;
+
+            iconv(c->cd, NULL, NULL, NULL, NULL); // initial shift state.
+            result = iconv(c->cd, inbuf, inbytesleft, outbuf, outbytesleft);
 
             if (result == (size_t)(-1)) {
                 warning("\t\t%s %d: iconv failed.\n", __FUNCTION__, __LINE__);
@@ -315,12 +495,6 @@ char_coding(
                 err++;
             }
 
-            if (iconv_close(conversion_descriptor) == -1) {
-                warning("\t\t%s %d: iconv_close failed.\n", __FUNCTION__, __LINE__);
-                info("\t\t%s\n", strerror(errno));
-                err++;
-            }
-
             **outbuf = 0;
             return;
         }
@@ -376,12 +550,28 @@ clean_str(char const *in, char *outbuf)
     outbuf[pos++] = 0;
 }
 
+/* codepage names already looked up; char_coding() asks for the same few names over and over. */
+struct codepage_name {
+    char *name;
+    int idx;
+};
+
+static struct codepage_name *codepage_names = NULL;
+static unsigned codepage_names_count = 0;
+
 int
 get_codepage_index(char const *codepage)
 {
     unsigned i;
     int idx = -1;
-    char *buf = strdup(codepage);
+    char *buf;
+
+    for (i = 0; i < codepage_names_count; i++) {
+        if (!strcmp(codepage_names[i].name, codepage))
+            return codepage_names[i].idx;
+    }
+
+    buf = strdup(codepage);
 
     clean_str(codepage, buf);
 
@@ -401,8 +591,11 @@ get_codepage_index(char const *codepage)
     free(buf);
     if (idx < 0) {
         warning("unknown codepage '%s', using default 'UTF-8'\n", codepage);
-        idx = get_codepage_index("UTF-8");
+        return get_codepage_index("UTF-8");
     }
+    codepage_names = realloc(codepage_names, (codepage_names_count + 1) * sizeof(struct codepage_name));
+    codepage_names[codepage_names_count].name = strdup(codepage);
+    codepage_names[codepage_names_count++].idx = idx;
     return idx;
 }
 
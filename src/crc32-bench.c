@@ -0,0 +1,96 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+/*
+ * crc32-bench: compares crc32_mpeg2() against the bytewise table crc
+ * on random sections of typical and maximum size.
+ *     make crc32-bench && ./crc32-bench [seconds per test]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "crc32.h"
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double
+bench(uint32_t (*crc)(unsigned char const *, size_t), unsigned char const *buf, size_t len, double seconds)
+{
+    double start = now(), elapsed;
+    unsigned long n = 0;
+    volatile uint32_t sink = 0;
+
+    do {
+        int i;
+        for (i = 0; i < 1000; i++)
+            sink ^= crc(buf, len);
+        n += 1000;
+        elapsed = now() - start;
+    } while (elapsed < seconds);
+    (void)sink;
+    return n * len / elapsed / 1e6;
+}
+
+int
+main(int argc, char **argv)
+{
+    static unsigned char buf[4096];
+    size_t sizes[] = { 188, 1024, 4096 };
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    size_t i, len;
+
+    srand(1);
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = rand();
+
+    for (len = 0; len <= sizeof(buf); len++) {
+        if (crc32_mpeg2(buf, len) != crc32_mpeg2_bytewise(buf, len)) {
+            printf("crc mismatch at length %zu\n", len);
+            return 1;
+        }
+    }
+    // a section followed by its crc gives 0.
+    {
+        uint32_t crc = crc32_mpeg2(buf, 1020);
+        buf[1020] = crc >> 24;
+        buf[1021] = crc >> 16;
+        buf[1022] = crc >> 8;
+        buf[1023] = crc;
+        if (crc32_mpeg2(buf, 1024) != 0) {
+            printf("crc over section incl. CRC_32 not zero\n");
+            return 1;
+        }
+    }
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        double bytewise = bench(crc32_mpeg2_bytewise, buf, sizes[i], seconds);
+        double sliced = bench(crc32_mpeg2, buf, sizes[i], seconds);
+        printf("%4zu bytes: bytewise %8.1f MB/s, slice-by-8 %8.1f MB/s (x%.2f)\n", sizes[i], bytewise, sliced, sliced / bytewise);
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#include <pthread.h>
+#include "crc32.h"
+
+#define CRC32_POLY 0x04C11DB7
+
+/* crc_table[0] is the usual byte table, crc_table[k][i] is the crc of byte i
+ * followed by k zero bytes. Eight bytes are processed with eight lookups
+ * (slice-by-8), the crc doesn't depend on the previous lookup within them.
+ */
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void
+crc_table_init(void)
+{
+    uint32_t i, j, accu;
+
+    for (i = 0; i < 256; i++) {
+        accu = i << 24;
+        for (j = 0; j < 8; j++)
+            accu = (accu & 0x80000000) ? (accu << 1) ^ CRC32_POLY : accu << 1;
+        crc_table[0][i] = accu;
+    }
+    for (i = 0; i < 256; i++) {
+        for (j = 1; j < 8; j++)
+            crc_table[j][i] = (crc_table[j - 1][i] << 8) ^ crc_table[0][crc_table[j - 1][i] >> 24];
+    }
+}
+
+uint32_t
+crc32_mpeg2_bytewise(unsigned char const *buf, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    pthread_once(&crc_table_once, crc_table_init);
+    while (len--)
+        crc = (crc << 8) ^ crc_table[0][(crc >> 24) ^ *buf++];
+    return crc;
+}
+
+uint32_t
+crc32_mpeg2(unsigned char const *buf, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    pthread_once(&crc_table_once, crc_table_init);
+    for (; len >= 8; len -= 8, buf += 8) {
+        crc ^= (uint32_t)buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3];
+        crc = crc_table[7][crc >> 24] ^ crc_table[6][(crc >> 16) & 0xFF] ^ crc_table[5][(crc >> 8) & 0xFF] ^
+            crc_table[4][crc & 0xFF] ^ crc_table[3][buf[4]] ^ crc_table[2][buf[5]] ^ crc_table[1][buf[6]] ^
+            crc_table[0][buf[7]];
+    }
+    while (len--)
+        crc = (crc << 8) ^ crc_table[0][(crc >> 24) ^ *buf++];
+    return crc;
+}
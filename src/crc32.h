@@ -0,0 +1,38 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* CRC-32/MPEG-2 (ISO/IEC 13818-1 Annex A) as used by PSI/SI sections:
+ * polynomial 0x04C11DB7, msb first, initial value 0xFFFFFFFF, no final xor.
+ * Running crc32_mpeg2() over a complete section incl. its CRC_32 field gives 0.
+ */
+
+uint32_t crc32_mpeg2(unsigned char const *buf, size_t len);
+
+/* one byte at a time; reference for crc32-bench. */
+uint32_t crc32_mpeg2_bytewise(unsigned char const *buf, size_t len);
+
+#endif
@@ -29,9 +29,44 @@
 #include "descriptors.h"
 #include "atsc_psip_section.h"
 #include "char-coding.h"
+#include "crc32.h"
 
 #define hd(d)  hexdump(__FUNCTION__, d + 2, d[1])
 
+/******************************************************************************
+ * descriptor loop iterator, see descriptors.h
+ *****************************************************************************/
+
+void
+descriptor_iter_init(struct descriptor_iter *it, unsigned char const *buf, int len, uint32_t const *skip)
+{
+    it->pos = buf;
+    it->end = buf + (len > 0 ? len : 0);
+    it->skip = skip;
+}
+
+bool
+descriptor_next(struct descriptor_iter *it, struct descriptor *d)
+{
+    while (it->end - it->pos >= 2) {
+        unsigned char const *buf = it->pos;
+
+        if (it->end - buf < buf[1] + 2) {
+            debug("descriptor_tag == 0x%02x, len %u exceeds descriptor loop\n", buf[0], buf[1]);
+            break;
+        }
+        it->pos += buf[1] + 2;
+        if (it->skip && descriptor_set_has(it->skip, buf[0]))
+            continue;
+        d->tag = buf[0];
+        d->length = buf[1];
+        d->buf = buf;
+        return true;
+    }
+    it->pos = it->end;
+    return false;
+}
+
 /******************************************************************************
  * returns minimum repetition rates as specified in ETR211 4.4.1 and 4.4.2
  * and 13818-1 C.9 Bandwidth Utilization and Signal Acquisition Time
@@ -63,6 +98,8 @@ repetition_rate(scantype_t scan_type, enum table_id table)
         case TABLE_BAT:
         case TABLE_SDT_OTH:
         case TABLE_EIT_OTH:
+        case TABLE_FASTSCAN_FNT:
+        case TABLE_FASTSCAN_FST:
             return 10;
         case TABLE_EIT_SCHEDULE_OTH_60 ... TABLE_EIT_SCHEDULE_OTH_60:
         case TABLE_TDT:
@@ -2382,33 +2419,11 @@ parse_SH_delivery_system_descriptor(unsigned char const *buf, struct transponder
 void parse_SH_delivery_system_descriptor(unsigned char const *buf, struct transponder *t, fe_spectral_inversion_t inversion) {};
 #endif
 
-    static __u32 crc_table[256];
-    static __u8 crc_initialized = 0;
-
     int crc_check(unsigned char const *buf, __u16 len)
     {
-        __u16 i, j;
-        __u32 crc = 0xffffffff;
+        __u32 crc = crc32_mpeg2(buf, len - 4);
         __u32 transmitted_crc = buf[len - 4] << 24 | buf[len - 3] << 16 | buf[len - 2] << 8 | buf[len - 1];
 
-        if (!crc_initialized) { // initialize crc lookup table before first use.
-            __u32 accu;
-            for (i = 0; i < 256; i++) {
-                accu = ((__u32)i << 24);
-                for (j = 0; j < 8; j++) {
-                    if (accu & 0x80000000L)
-                        accu = (accu << 1) ^ 0x04C11DB7L; // CRC32 Polynom
-                    else
-                        accu = (accu << 1);
-                }
-                crc_table[i] = accu;
-            }
-            crc_initialized = 1;
-        }
-
-        for (i = 0; i < len - 4; i++)
-            crc = (crc << 8) ^ crc_table[((crc >> 24) ^ *buf++) & 0xFF];
-
         if (crc == transmitted_crc)
             return 1;
         else {
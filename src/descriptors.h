@@ -22,6 +22,8 @@
 #ifndef __DESCRIPTORS_H__
 #define __DESCRIPTORS_H__
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "extended_frontend.h"
 #include "time.h"
 
@@ -205,6 +207,8 @@ enum table_id {
     TABLE_DIT = 0x7E, // discontinuity_information_section
     TABLE_SIT = 0x7F, // selection_information_section
     TABLE_PREMIERE_CIT = 0xA0, // premiere content information section
+    TABLE_FASTSCAN_FNT = 0xBC, // M7 FastScan network table, NIT syntax
+    TABLE_FASTSCAN_FST = 0xBD, // M7 FastScan services table
     TABLE_VCT_TERR = 0xC8, // ATSC VCT VSB (terr)
     TABLE_VCT_CABLE = 0xC9, // ATSC VCT QAM (cable)
 };
@@ -320,6 +324,32 @@ typedef struct {
     changed_network_t *network;
 } network_change_t;
 
+/******************************************************************************
+ * descriptor loop iterator.
+ *
+ * walks the (tag, length, payload) descriptors of a descriptor loop in place,
+ * never beyond the end of the loop: a truncated descriptor ends the walk.
+ * Tags in the optional skip set are stepped over without being returned.
+ *****************************************************************************/
+#define DESCRIPTOR_SET_WORDS (256 / 32)
+#define descriptor_set_add(set, tag) ((set)[(uint8_t)(tag) >> 5] |= 1U << ((tag) & 31))
+#define descriptor_set_has(set, tag) (((set)[(uint8_t)(tag) >> 5] >> ((tag) & 31)) & 1)
+
+struct descriptor_iter {
+    unsigned char const *pos;
+    unsigned char const *end;
+    uint32_t const *skip; // NULL: return all descriptors.
+};
+
+struct descriptor {
+    uint8_t tag;
+    uint8_t length; // payload length, w/o tag and length byte.
+    unsigned char const *buf; // descriptor incl. tag and length, as expected by parse_*_descriptor().
+};
+
+void descriptor_iter_init(struct descriptor_iter *it, unsigned char const *buf, int len, uint32_t const *skip);
+bool descriptor_next(struct descriptor_iter *it, struct descriptor *d);
+
 int repetition_rate(scantype_t scan_type, enum table_id table);
 void parse_service_descriptor(
     unsigned char const *buf,
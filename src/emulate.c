@@ -3,8 +3,14 @@
 #include <stdint.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "emulate.h"
+#include "ts-demux.h"
 
 #include "dump-vdr.h" // debugging transponder.
 #include "dump-xine.h" // debugging transponder.
@@ -18,32 +24,114 @@
 // #define EM_INFO(msg...) info(msg)
 #define EM_INFO(msg...)
 
-/* this struct stores the contents (DVB SI data) of an section buffer,
- * alltogether with the current tuning state of the dvb device.
+/* this struct stores the header of an section buffer (DVB SI data) in em_arena,
+ * directly followed by 'len' bytes of section data. The tuning state of the dvb
+ * device is stored only once per transponder, see em_tps.
  */
 typedef struct {
-    /*----------------------------*/
-    void *prev;
-    void *next;
-    uint32_t index;
-    /*----------------------------*/
+    uint16_t len;
     uint16_t pid;
     uint16_t table_id;
     uint16_t table_id_ext;
-    uint16_t original_network_id;
     uint16_t network_id;
     uint16_t transport_stream_id;
     uint16_t service_id;
-    uint16_t len;
-    struct transponder t;
-    unsigned char buf[SECTION_BUF_SIZE];
+    uint16_t delay; // msec after tuning, binary captures only.
+    uint32_t tp;    // index into em_tps.
 } sidata_t;
 
+#define SIDATA_BUF(s) ((unsigned char *)(s) + sizeof(sidata_t))
+
 /*
- * list of DVB SI data and list of running demux filters.
+ * list of running demux filters.
  */
 cList __em_buf1, *em_runningfilters = &__em_buf1;
-cList __em_buf2, *em_sidata = &__em_buf2;
+
+/*
+ * all sections from logfile, in logfile order. Sections are referenced by
+ * their offset, as em_arena is moved while growing.
+ */
+static unsigned char *em_arena = NULL;
+static uint32_t em_arena_len = 0;
+static uint32_t em_arena_size = 0;
+static uint32_t em_section_count = 0;
+
+/*
+ * section being read from logfile.
+ */
+static struct {
+    sidata_t s;
+    unsigned char buf[SECTION_BUF_SIZE];
+} em_scratch;
+
+/*
+ * all distinct tuning states found in logfile. Lock is evaluated once
+ * per transponder and tune, instead of once per section and filter.
+ */
+typedef struct {
+    struct transponder t;
+    bool locked;
+    uint16_t lock_delay; // msec after tuning, binary captures only.
+} em_tp_t;
+
+static em_tp_t *em_tps = NULL;
+static uint32_t em_tp_count = 0;
+static uint32_t em_tp_size = 0;
+
+static uint32_t em_tuning = 1;      // incremented on each change of em_device tuning.
+static uint32_t em_lock_tuning = 0; // em_tuning, for which em_tps[].locked is valid.
+static uint32_t *em_locked = NULL;  // indices of locked em_tps, in order of em_tps.
+static uint32_t em_locked_count = 0;
+
+/*
+ * sections, indexed by transponder, table_id and pid (PMT only).
+ * offsets into em_arena are stored in logfile order; table_id_ext is
+ * checked while walking a bucket, as most buckets hold only a few sections.
+ */
+typedef struct em_bucket {
+    struct em_bucket *next;
+    uint32_t tp;
+    uint16_t table_id;
+    uint16_t pid;
+    uint32_t count;
+    uint32_t size;
+    uint32_t *sections;
+} em_bucket_t;
+
+static em_bucket_t **em_index = NULL;
+static uint32_t em_index_size = 0; // power of 2.
+static uint32_t em_index_count = 0;
+
+/*
+ * binary captures: a header followed by records, each padded to 8 bytes.
+ * All values in host byte order, times in usec on CLOCK_MONOTONIC since
+ * start of capture.
+ */
+#define EM_CAPTURE_MAGIC   "w_scan2 capture"
+#define EM_CAPTURE_VERSION 1
+#define EM_ALIGN(n)        (((n) + 7) & ~7)
+
+typedef struct {
+    char magic[16];
+    uint32_t version;
+    uint32_t reserved;
+} em_capture_header_t;
+
+typedef struct {
+    uint64_t time;
+    uint32_t len; // bytes of data following this header.
+    uint16_t type; // enum em_record_type
+    uint16_t arg;
+} em_record_t;
+
+static FILE *em_capture_file = NULL;
+static struct timespec em_capture_start;
+
+/*
+ * replay speed: 0 = as fast as possible, 1 = real-time, N = N times faster.
+ */
+static double em_speed = 0;
+static struct timespec em_tuned; // time of last em_setproperty().
 
 /*
  * drivers DVB API.
@@ -98,6 +186,7 @@ static struct {
  * forward declarations.
  */
 static int parse_logfile(char const *log);
+static int load_capture(char const *file);
 
 // Declare parse_xyz in scan.h? Hmm..
 extern void parse_pat(unsigned char const *buf, uint16_t section_length, uint16_t transport_stream_id, uint32_t flags);
@@ -109,18 +198,32 @@ extern void parse_nit(
     uint16_t network_id,
     uint32_t section_flags);
 extern void parse_sdt(unsigned char const *buf, uint16_t section_length, uint16_t transport_stream_id);
+extern void parse_sdt_other(unsigned char const *buf, uint16_t section_length, uint16_t transport_stream_id);
 extern void parse_psip_vct(unsigned char const *buf, uint16_t section_length, uint8_t table_id, uint16_t transport_stream_id);
 
 /*
- * initializes emulated dvb device and fills in data by parsing logfile.
+ * initializes emulated dvb device and fills in data by parsing logfile
+ * or loading a binary capture. log == NULL: empty device.
  */
 void
 em_init(char const *log)
 {
+    em_capture_header_t h;
+    FILE *f;
+    bool binary = false;
+
     NewList(em_runningfilters, "em_runningfilters");
-    NewList(em_sidata, "em_sidata");
     memset(&em_device, 0, sizeof(em_device));
-    parse_logfile(log);
+    if (log == NULL) // transport stream files only, see em_add_tsfile().
+        return;
+    if ((f = fopen(log, "r")) != NULL) {
+        binary = (fread(&h, sizeof(h), 1, f) == 1) && (memcmp(h.magic, EM_CAPTURE_MAGIC, sizeof(EM_CAPTURE_MAGIC)) == 0);
+        fclose(f);
+    }
+    if (binary)
+        load_capture(log);
+    else
+        parse_logfile(log);
 }
 
 /*
@@ -157,6 +260,8 @@ int
 em_setproperty(struct dtv_properties *cmdseq)
 {
     uint8_t i;
+    em_tuning++;
+    clock_gettime(CLOCK_MONOTONIC, &em_tuned);
     for (i = 0; i < cmdseq->num; i++) {
         switch (cmdseq->props[i].cmd) {
         case DTV_DELIVERY_SYSTEM:
@@ -272,18 +377,52 @@ em_getproperty(struct dtv_properties *cmdseq)
     return 0; // no err.
 }
 
+/*
+ * sets LNB state, also called without emulation for binary captures.
+ */
 void
 em_lnb(bool high_band, uint32_t high_val, uint32_t low_val)
 {
+    uint32_t lof[2] = { high_val, low_val };
+
     em_device.highband = high_band;
     em_device.lnb_low = low_val;
     em_device.lnb_high = high_val;
+    em_tuning++;
+    em_record(EM_REC_LNB, high_band, lof, sizeof(lof));
 }
 
+/*
+ * sets polarization, also called without emulation for binary captures.
+ */
 void
 em_polarization(uint8_t p)
 {
     em_device.polarization = p & 0x3;
+    em_tuning++;
+    em_record(EM_REC_POLARIZATION, p, NULL, 0);
+}
+
+/*
+ * with --replay-speed, wait until msec (binary captures: as captured) after tuning.
+ */
+static void
+em_wait(uint32_t msec)
+{
+    struct timespec until = em_tuned;
+    uint64_t nsec;
+
+    if (em_speed <= 0)
+        return;
+    nsec = (uint64_t)(msec * 1e6 / em_speed);
+    until.tv_sec += nsec / 1000000000;
+    until.tv_nsec += nsec % 1000000000;
+    if (until.tv_nsec >= 1000000000) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR)
+        ;
 }
 
 /*
@@ -410,26 +549,206 @@ has_lock(fe_delivery_system_t em_delsys, struct transponder *t)
     return 0;
 }
 
+/*
+ * evaluates lock of all transponders, if tuning changed since last call.
+ * NOTE: has_lock() may change em_device.delsys (T2_delsys_bug), therefore
+ *       transponders are evaluated in logfile order, as before.
+ */
+static void
+em_update_lock(void)
+{
+    uint32_t i;
+    fe_delivery_system_t delsys = em_device.delsys;
+
+    if (em_lock_tuning == em_tuning)
+        return;
+    em_lock_tuning = em_tuning;
+    em_locked_count = 0;
+    for (i = 0; i < em_tp_count; i++) {
+        em_tps[i].locked = has_lock(delsys, &em_tps[i].t) != 0;
+        if (em_tps[i].locked)
+            em_locked[em_locked_count++] = i;
+    }
+}
+
 /*
  * replaces FE_READ_STATUS ioctl.
  */
 int
 em_status(fe_status_t *status)
 {
-    sidata_t *s;
+    em_update_lock();
+    *status = em_locked_count ? 0x1F : 0; // sync && lock.
+    if (em_locked_count)
+        em_wait(em_tps[em_locked[0]].lock_delay);
+    return 0;
+}
 
-    *status = 0;
-    for (s = em_sidata->first; s; s = s->next) {
-        // char b[256];
-        // print_transponder(b, &s->t);
-        // info("%s: try %s (current: %d lo %d highband=%d)\n",__FUNCTION__,b, em_device.frequency,
-        // em_device.highband?em_device.lnb_high:em_device.lnb_low, em_device.highband);
-        if (has_lock(em_device.delsys, &s->t)) {
-            *status = 0x1F; // sync && lock.
-            break;
+/*
+ * returns index of transponder in em_tps, adds a new one if not yet known.
+ */
+static uint32_t
+em_find_tp(struct transponder *t)
+{
+    size_t len = (char *)&t->private_from_here - (char *)&t->frequency;
+    uint32_t i;
+
+    for (i = 0; i < em_tp_count; i++) {
+        if (memcmp(&em_tps[i].t.frequency, &t->frequency, len) == 0)
+            return i;
+    }
+    if (em_tp_count == em_tp_size) {
+        em_tp_size = em_tp_size ? 2 * em_tp_size : 64;
+        em_tps = realloc(em_tps, em_tp_size * sizeof(em_tp_t));
+        em_locked = realloc(em_locked, em_tp_size * sizeof(uint32_t));
+        if ((em_tps == NULL) || (em_locked == NULL))
+            fatal("%s: out of memory.\n", __FUNCTION__);
+    }
+    memset(&em_tps[em_tp_count], 0, sizeof(em_tp_t));
+    memcpy(&em_tps[em_tp_count].t.frequency, &t->frequency, len);
+    return em_tp_count++;
+}
+
+/*
+ * fills in the tuning state of the emulated dvb device.
+ */
+static void
+em_device_transponder(struct transponder *t)
+{
+    memset(t, 0, sizeof(struct transponder));
+    t->frequency = em_device.frequency;
+    t->inversion = em_device.inversion;
+    switch (em_device.delsys) {
+    case SYS_DVBT:
+    case SYS_DVBT2:
+        t->type = SCAN_TERRESTRIAL;
+        t->bandwidth = em_device.bandwidth_hz;
+        t->coderate = em_device.fec;
+        t->coderate_LP = FEC_AUTO;
+        t->modulation = em_device.modulation;
+        t->transmission = em_device.transmission;
+        t->guard = em_device.guard;
+        t->hierarchy = em_device.hierarchy;
+        t->delsys = em_device.delsys;
+        break;
+    case SYS_DVBC_ANNEX_A:
+    case SYS_DVBC_ANNEX_C:
+        t->type = SCAN_CABLE;
+        t->delsys = em_device.delsys;
+        t->modulation = em_device.modulation;
+        t->symbolrate = em_device.symbolrate;
+        break;
+    case SYS_DVBS:
+    case SYS_DVBS2:
+        t->type = SCAN_SATELLITE;
+        t->rolloff = em_device.rolloff;
+        t->pilot = em_device.pilot;
+        t->delsys = em_device.delsys;
+        t->polarization = em_device.polarization;
+        t->coderate = em_device.fec;
+        t->symbolrate = em_device.symbolrate;
+        t->modulation = em_device.modulation;
+        break;
+    case SYS_ATSC:
+        t->type = SCAN_TERRCABLE_ATSC;
+        t->delsys = em_device.delsys;
+        t->modulation = em_device.modulation;
+        break;
+    default:
+        fatal("unsupported del sys.\n");
+    }
+}
+
+static uint32_t
+em_hash(uint32_t tp, uint16_t table_id, uint16_t pid)
+{
+    uint32_t h = (tp * 0x9E3779B1) ^ (table_id << 16) ^ pid;
+
+    h ^= h >> 15;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    return h & (em_index_size - 1);
+}
+
+static em_bucket_t *
+em_find_bucket(uint32_t tp, uint16_t table_id, uint16_t pid)
+{
+    em_bucket_t *b;
+
+    if (em_index_size == 0)
+        return NULL;
+    for (b = em_index[em_hash(tp, table_id, pid)]; b; b = b->next) {
+        if ((b->tp == tp) && (b->table_id == table_id) && (b->pid == pid))
+            return b;
+    }
+    return NULL;
+}
+
+static void
+em_index_grow(void)
+{
+    em_bucket_t **old = em_index, *b, *next;
+    uint32_t i, old_size = em_index_size;
+
+    em_index_size = em_index_size ? 2 * em_index_size : 1024;
+    if ((em_index = calloc(em_index_size, sizeof(em_bucket_t *))) == NULL)
+        fatal("%s: out of memory.\n", __FUNCTION__);
+    for (i = 0; i < old_size; i++) {
+        for (b = old[i]; b; b = next) {
+            uint32_t h = em_hash(b->tp, b->table_id, b->pid);
+            next = b->next;
+            b->next = em_index[h];
+            em_index[h] = b;
         }
     }
-    return 0;
+    free(old);
+}
+
+/*
+ * appends a section from logfile to em_arena and adds it to the index.
+ */
+static void
+em_store_section(sidata_t *sidata, unsigned char const *buf)
+{
+    uint16_t pid = sidata->table_id == TABLE_PMT ? sidata->pid : 0;
+    uint32_t size = (sizeof(sidata_t) + sidata->len + 3) & ~3; // keep headers aligned.
+    uint32_t offset = em_arena_len;
+    em_bucket_t *b;
+
+    if (em_arena_len + size > em_arena_size) {
+        if (em_arena_size > UINT32_MAX / 2)
+            fatal("%s: logfile too large.\n", __FUNCTION__);
+        while (em_arena_len + size > em_arena_size)
+            em_arena_size = em_arena_size ? 2 * em_arena_size : 65536;
+        if ((em_arena = realloc(em_arena, em_arena_size)) == NULL)
+            fatal("%s: out of memory.\n", __FUNCTION__);
+    }
+    memcpy(em_arena + offset, sidata, sizeof(sidata_t));
+    memcpy(em_arena + offset + sizeof(sidata_t), buf, sidata->len);
+    em_arena_len += size;
+    em_section_count++;
+
+    if ((b = em_find_bucket(sidata->tp, sidata->table_id, pid)) == NULL) {
+        uint32_t h;
+
+        if (em_index_count >= em_index_size)
+            em_index_grow();
+        if ((b = calloc(1, sizeof(em_bucket_t))) == NULL)
+            fatal("%s: out of memory.\n", __FUNCTION__);
+        b->tp = sidata->tp;
+        b->table_id = sidata->table_id;
+        b->pid = pid;
+        h = em_hash(b->tp, b->table_id, b->pid);
+        b->next = em_index[h];
+        em_index[h] = b;
+        em_index_count++;
+    }
+    if (b->count == b->size) {
+        b->size = b->size ? 2 * b->size : 4;
+        if ((b->sections = realloc(b->sections, b->size * sizeof(uint32_t))) == NULL)
+            fatal("%s: out of memory.\n", __FUNCTION__);
+    }
+    b->sections[b->count++] = offset;
 }
 
 /*----------------------------------------------------------------------------------------------------------------------
@@ -468,54 +787,85 @@ em_addfilter(struct section_buf *s)
     AddItem(em_runningfilters, s);
 }
 
+/*
+ * collects all sections matching filter from locked transponders, in logfile order.
+ * returns number of sections in *found.
+ */
+static uint32_t
+em_find_sections(struct section_buf *filter, uint32_t **found)
+{
+    static uint32_t *buf = NULL;
+    static uint32_t size = 0;
+    uint16_t pid = filter->table_id == TABLE_PMT ? filter->pid : 0;
+    uint32_t i, j, count = 0;
+
+    em_update_lock();
+    for (i = 0; i < em_locked_count; i++) {
+        em_bucket_t *b = em_find_bucket(em_locked[i], filter->table_id, pid);
+
+        if (b == NULL)
+            continue;
+        for (j = 0; j < b->count; j++) {
+            sidata_t *sidata = (sidata_t *)(em_arena + b->sections[j]);
+
+            if ((filter->table_id_ext != sidata->table_id_ext) && (filter->table_id_ext > -1)) {
+                EM_INFO(" -> wrong table_id_ext = %d\n", sidata->table_id_ext);
+                continue;
+            }
+            if (count == size) {
+                size = size ? 2 * size : 64;
+                if ((buf = realloc(buf, size * sizeof(uint32_t))) == NULL)
+                    fatal("%s: out of memory.\n", __FUNCTION__);
+            }
+            buf[count++] = b->sections[j];
+        }
+    }
+
+    if (em_locked_count > 1) {
+        // more than one transponder locked: merge by logfile order, i.e. by offset.
+        for (i = 1; i < count; i++) {
+            uint32_t offset = buf[i];
+
+            for (j = i; (j > 0) && (buf[j - 1] > offset); j--)
+                buf[j] = buf[j - 1];
+            buf[j] = offset;
+        }
+    }
+    *found = buf;
+    return count;
+}
+
 void
 em_readfilters(int *result)
 {
     sidata_t *sidata;
     struct section_buf *filter;
-    int maxiter = 10000;
+    uint32_t i, count, *found;
 
     while ((filter = em_runningfilters->first)) {
         bool data_found = false;
-        if (!maxiter--)
-            fatal("%s: max iterations.\n", __FUNCTION__);
-        for (sidata = em_sidata->first; sidata; sidata = sidata->next) {
-            if (filter->table_id != sidata->table_id) {
-                // info("(filter->table_id = %d != table_id = %d), table_id_ext = %d, pid = %d\n", filter->table_id,
-                // sidata->table_id, sidata->table_id_ext, sidata->pid);
-                continue;
-            }
-            EM_INFO(
-                "f=%-6d: searching %-10s: table_id_ext = %d, pid = %d\n",
-                freq_scale(em_device.frequency, 1e-3),
-                table_name(filter->table_id),
-                filter->table_id_ext,
-                filter->pid);
-
-            if (!has_lock(em_device.delsys, &sidata->t)) {
-                EM_INFO(" -> no lock @ %d\n", freq_scale(sidata->t.frequency, 1e-3));
-                continue;
-            }
 
-            if ((filter->pid != sidata->pid) && (filter->table_id == TABLE_PMT)) {
-                EM_INFO(" -> wrong pid %d\n", sidata->pid);
-                continue;
-            }
+        EM_INFO(
+            "f=%-6d: searching %-10s: table_id_ext = %d, pid = %d\n",
+            freq_scale(em_device.frequency, 1e-3),
+            table_name(filter->table_id),
+            filter->table_id_ext,
+            filter->pid);
 
-            if ((filter->table_id_ext != sidata->table_id_ext) && (filter->table_id_ext > -1)) {
-                EM_INFO(" -> wrong table_id_ext = %d\n", sidata->table_id_ext);
-                continue;
-            }
+        count = em_find_sections(filter, &found);
+        for (i = 0; i < count; i++) {
+            sidata = (sidata_t *)(em_arena + found[i]);
+            em_wait(sidata->delay);
             EM_INFO(" -> OK.\n");
             data_found = true;
 
             switch (filter->table_id) {
             case TABLE_PAT:
-                parse_pat(sidata->buf, sidata->len, sidata->transport_stream_id, filter->flags);
+                parse_pat(SIDATA_BUF(sidata), sidata->len, sidata->transport_stream_id, filter->flags);
                 break;
             case TABLE_NIT_ACT:
             case TABLE_NIT_OTH:
-                parse_nit(sidata->buf, sidata->len, filter->table_id, sidata->network_id, filter->flags);
+                parse_nit(SIDATA_BUF(sidata), sidata->len, filter->table_id, sidata->network_id, filter->flags);
                 break;
             case TABLE_PMT:
                 verbose(
@@ -524,7 +874,7 @@ em_readfilters(int *result)
                     sidata->pid,
                     sidata->service_id,
                     sidata->service_id);
-                parse_pmt(sidata->buf, sidata->len, sidata->service_id);
+                parse_pmt(SIDATA_BUF(sidata), sidata->len, sidata->service_id);
                 break;
             case TABLE_SDT_ACT:
             case TABLE_SDT_OTH:
@@ -533,12 +883,15 @@ em_readfilters(int *result)
                     filter->table_id == 0x42 ? "actual" : "other",
                     sidata->transport_stream_id,
                     sidata->transport_stream_id);
-                parse_sdt(sidata->buf, sidata->len, sidata->transport_stream_id);
+                if (filter->table_id == TABLE_SDT_OTH)
+                    parse_sdt_other(SIDATA_BUF(sidata), sidata->len, sidata->transport_stream_id);
+                else
+                    parse_sdt(SIDATA_BUF(sidata), sidata->len, sidata->transport_stream_id);
                 break;
             case TABLE_VCT_TERR:
             case TABLE_VCT_CABLE:
                 verbose("ATSC VCT, table_id %d, table_id_ext %d\n", sidata->table_id, sidata->table_id_ext);
-                parse_psip_vct(sidata->buf, sidata->len, filter->table_id, sidata->table_id_ext);
+                parse_psip_vct(SIDATA_BUF(sidata), sidata->len, filter->table_id, sidata->table_id_ext);
                 break;
             default:
                 fatal("%s %d: unhandled table_id %d\n", __FUNCTION__, __LINE__, filter->table_id);
@@ -550,6 +903,7 @@ em_readfilters(int *result)
         if (!data_found) {
             char const *intro = "        Info: no data from ";
             // timeout waiting for data.
+            em_wait(filter->timeout);
             switch (filter->table_id) {
             case TABLE_PAT:
             case TABLE_PMT:
@@ -559,10 +913,10 @@ em_readfilters(int *result)
             case TABLE_SDT_OTH:
             case TABLE_VCT_TERR:
             case TABLE_VCT_CABLE:
-                info("%s%s after %lld seconds\n", intro, table_name(filter->table_id), (long long)filter->timeout);
+                info("%s%s after %u msec\n", intro, table_name(filter->table_id), filter->timeout);
                 break;
             default:
-                info("%spid %u after %lld seconds\n", intro, filter->pid, (long long)filter->timeout);
+                info("%spid %u after %u msec\n", intro, filter->pid, filter->timeout);
             }
             *result = 0;
         }
@@ -920,7 +1274,7 @@ parse_logfile(char const *log)
     char *line = (char *)calloc(1, 256);
     char *p;
     int pid = 0, table_id = -1, len = 0, line_no = 0;
-    uint16_t original_network_id = 0, network_id = 0, transport_stream_id = 0;
+    uint16_t network_id = 0, transport_stream_id = 0;
     uint16_t service_id = 0, pmt_pid = 0;
     int dev_props = 0;
     sidata_t *sidata = NULL;
@@ -1323,49 +1677,14 @@ parse_logfile(char const *log)
         if (strstr(line, "	len = ")) {
             sscanf(line, "	len = %d", &len);
             if (len > 0) {
-                sidata = (sidata_t *)calloc(1, sizeof(sidata_t));
-                sidata->t.frequency = em_device.frequency;
-                sidata->t.inversion = em_device.inversion;
-                switch (em_device.delsys) {
-                case SYS_DVBT:
-                case SYS_DVBT2:
-                    sidata->t.type = SCAN_TERRESTRIAL;
-                    sidata->t.bandwidth = em_device.bandwidth_hz;
-                    sidata->t.coderate = em_device.fec;
-                    sidata->t.coderate_LP = FEC_AUTO;
-                    sidata->t.modulation = em_device.modulation;
-                    sidata->t.transmission = em_device.transmission;
-                    sidata->t.guard = em_device.guard;
-                    sidata->t.hierarchy = em_device.hierarchy;
-                    sidata->t.delsys = em_device.delsys;
-                    break;
-                case SYS_DVBC_ANNEX_A:
-                case SYS_DVBC_ANNEX_C:
-                    sidata->t.type = SCAN_CABLE;
-                    sidata->t.delsys = em_device.delsys;
-                    sidata->t.modulation = em_device.modulation;
-                    sidata->t.symbolrate = em_device.symbolrate;
-                    break;
-                case SYS_DVBS:
-                case SYS_DVBS2:
-                    sidata->t.type = SCAN_SATELLITE;
-                    sidata->t.rolloff = em_device.rolloff;
-                    sidata->t.pilot = em_device.pilot;
-                    sidata->t.delsys = em_device.delsys;
-                    sidata->t.polarization = em_device.polarization;
-                    sidata->t.coderate = em_device.fec;
-                    sidata->t.symbolrate = em_device.symbolrate;
-                    sidata->t.modulation = em_device.modulation;
-                    break;
-                case SYS_ATSC:
-                    sidata->t.type = SCAN_TERRCABLE_ATSC;
-                    /* falls through */
-                default:
-                    fatal("unsupported del sys.\n");
-                }
+                struct transponder t;
+
+                em_device_transponder(&t);
+                sidata = &em_scratch.s;
+                memset(sidata, 0, sizeof(sidata_t));
+                sidata->tp = em_find_tp(&t);
                 sidata->pid = pid;
                 sidata->table_id = table_id;
-                sidata->original_network_id = original_network_id;
                 sidata->network_id = network_id;
                 sidata->transport_stream_id = transport_stream_id;
                 sidata->service_id = service_id;
@@ -1397,7 +1716,7 @@ parse_logfile(char const *log)
 				//     sidata->table_id == TABLE_SDT_OTH?"SDT(oth)":                                          \
 				//     sidata->table_id == TABLE_PMT    ?"PMT":"---ERROR---" ,                                \
 				//     sidata->table_id_ext, sidata->pid,                                                     \
-				//     sidata->original_network_id, sidata->network_id, sidata->transport_stream_id);
+				//     sidata->network_id, sidata->transport_stream_id);
             }
             continue;
         }
@@ -1438,8 +1757,8 @@ parse_logfile(char const *log)
                     len -= (nitems - 1);
                     // EM_INFO("%d: '%-80s' (%d bytes left)\n", line_no, line, len);
 
-                    for (i = 0; i < nitems - 1; i++)
-                        sidata->buf[sidata->len++] = args[i];
+                    for (i = 0; (i < nitems - 1) && (sidata->len < SECTION_BUF_SIZE - 2); i++)
+                        em_scratch.buf[sidata->len++] = args[i];
                     if (len < 1) {
                         // info("line %d\n", line_no);
                         // switch(table_id) {
@@ -1464,11 +1783,11 @@ parse_logfile(char const *log)
                         if (em_device.w_scan_flags & EM_HEXDUMP_BUG) {
                             // each sections hexdump misses two bytes, because of bug in older versions. :(
                             // those are really lost in logfile && not recoverable.
-                            sidata->buf[sidata->len++] = 0;
-                            sidata->buf[sidata->len++] = 0;
+                            em_scratch.buf[sidata->len++] = 0;
+                            em_scratch.buf[sidata->len++] = 0;
                         }
-                        // hexdump("sidata", &sidata->buf[0], sidata->len);
-                        AddItem(em_sidata, sidata);
+                        // hexdump("sidata", &em_scratch.buf[0], sidata->len);
+                        em_store_section(sidata, em_scratch.buf);
                         sidata = NULL;
                     }
                 }
@@ -1479,3 +1798,368 @@ parse_logfile(char const *log)
     free(line);
     return 1;
 }
+
+/*
+ * returns index in em_tps of the current tuning of a captured device.
+ */
+static uint32_t
+capture_tp(void)
+{
+    struct transponder t;
+
+    em_device_transponder(&t);
+    if (t.type == SCAN_SATELLITE) // em_device.frequency is the intermediate frequency.
+        t.frequency += em_device.highband ? em_device.lnb_high : em_device.lnb_low;
+    return em_find_tp(&t);
+}
+
+/*
+ * adds a captured section to em_arena, if it belongs to a table known by emulation.
+ */
+static bool
+load_section(uint32_t tp, uint16_t pid, unsigned char const *buf, uint32_t len, uint32_t delay)
+{
+    sidata_t sidata;
+    uint16_t table_id_ext;
+
+    if ((len < 12) || (len > SECTION_BUF_SIZE))
+        return false;
+    memset(&sidata, 0, sizeof(sidata));
+    table_id_ext = (buf[3] << 8) | buf[4];
+    switch (buf[0]) {
+    case TABLE_PAT:
+    case TABLE_SDT_ACT:
+    case TABLE_SDT_OTH:
+        sidata.transport_stream_id = table_id_ext;
+        break;
+    case TABLE_PMT:
+        sidata.service_id = table_id_ext;
+        break;
+    case TABLE_NIT_ACT:
+    case TABLE_NIT_OTH:
+        sidata.network_id = table_id_ext;
+        break;
+    case TABLE_VCT_TERR:
+    case TABLE_VCT_CABLE:
+        break;
+    default:
+        return false;
+    }
+    sidata.len = len - 12; // w/o 8 byte header and CRC, as parse_xyz() expects.
+    sidata.pid = pid;
+    sidata.table_id = buf[0];
+    sidata.table_id_ext = table_id_ext;
+    sidata.delay = delay > 0xFFFF ? 0xFFFF : delay;
+    sidata.tp = tp;
+    em_store_section(&sidata, buf + 8);
+    return true;
+}
+
+/*
+ * reads a binary capture, see em_capture().
+ */
+static int
+load_capture(char const *file)
+{
+    em_capture_header_t const *h;
+    unsigned char const *map, *p, *end;
+    struct stat st;
+    uint64_t tuned = 0; // time of last EM_REC_SET_PROPERTY.
+    uint32_t i, j, n;
+    int fd;
+
+    if ((fd = open(file, O_RDONLY)) < 0)
+        fatal("cannot open '%s': error %d %s\n", file, errno, strerror(errno));
+    if ((fstat(fd, &st) < 0) || (st.st_size < (off_t)sizeof(em_capture_header_t)))
+        fatal("cannot read '%s'.\n", file);
+    if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+        fatal("cannot mmap '%s': error %d %s\n", file, errno, strerror(errno));
+    close(fd);
+
+    h = (em_capture_header_t const *)map;
+    if (h->version != EM_CAPTURE_VERSION)
+        fatal("%s: unsupported capture version %u.\n", file, h->version);
+    em_device.scantype = SCAN_UNDEFINED;
+
+    end = map + st.st_size;
+    for (p = map + sizeof(em_capture_header_t); p + sizeof(em_record_t) <= end;) {
+        em_record_t const *r = (em_record_t const *)p;
+        unsigned char const *data = p + sizeof(em_record_t);
+        struct dtv_properties cmdseq;
+        uint32_t delay;
+
+        if (r->len > (size_t)(end - data)) {
+            warning("%s: capture truncated.\n", file);
+            break;
+        }
+        p = data + EM_ALIGN(r->len);
+        delay = (r->time - tuned) / 1000;
+
+        switch (r->type) {
+        case EM_REC_FE_INFO:
+            memcpy(&em_device.fe_info, data, r->len < sizeof(em_device.fe_info) ? r->len : sizeof(em_device.fe_info));
+            em_device.T2_delsys_bug = strstr(em_device.fe_info.name, "CXD2820R") != NULL;
+            break;
+        case EM_REC_API_VERSION:
+            em_api.major = r->arg >> 8;
+            em_api.minor = r->arg & 0xFF;
+            break;
+        case EM_REC_SET_PROPERTY:
+            cmdseq.num = r->len / sizeof(struct dtv_property);
+            cmdseq.props = (struct dtv_property *)data;
+            em_setproperty(&cmdseq);
+            tuned = r->time;
+            break;
+        case EM_REC_GET_PROPERTY:
+            n = r->len / sizeof(struct dtv_property);
+            for (i = 0; i < n; i++) {
+                struct dtv_property const *prop = (struct dtv_property const *)data + i;
+
+                if (prop->cmd != DTV_ENUM_DELSYS)
+                    continue;
+                // em_getproperty() returns them in reverse order.
+                em_device.ndelsystems = prop->u.buffer.len > 32 ? 32 : prop->u.buffer.len;
+                for (j = 0; j < em_device.ndelsystems; j++)
+                    em_device.delsystems[em_device.ndelsystems - 1 - j] = prop->u.buffer.data[j];
+            }
+            break;
+        case EM_REC_LNB:
+            if (r->len >= 2 * sizeof(uint32_t))
+                em_lnb(r->arg, ((uint32_t const *)data)[0], ((uint32_t const *)data)[1]);
+            break;
+        case EM_REC_POLARIZATION:
+            em_polarization(r->arg);
+            break;
+        case EM_REC_STATUS:
+            if (r->arg & FE_HAS_LOCK) {
+                uint32_t tp = capture_tp();
+
+                if (em_tps[tp].lock_delay == 0)
+                    em_tps[tp].lock_delay = delay > 0xFFFF ? 0xFFFF : delay > 0 ? delay : 1;
+            }
+            break;
+        case EM_REC_SECTION:
+            load_section(capture_tp(), r->arg, data, r->len, delay);
+            break;
+        default:
+            verbose("%s: unknown record type %u.\n", file, r->type);
+        }
+    }
+    munmap((void *)map, st.st_size);
+    info("%s: %u sections from %u transponders.\n", file, em_section_count, em_tp_count);
+    return 1;
+}
+
+static void
+em_capture_close(void)
+{
+    if (em_capture_file != NULL)
+        fclose(em_capture_file);
+    em_capture_file = NULL;
+}
+
+/*
+ * starts a binary capture of everything the dvb device reports,
+ * which may be replayed later by -a FILE.
+ */
+void
+em_capture(char const *file)
+{
+    em_capture_header_t h;
+
+    if ((em_capture_file = fopen(file, "w")) == NULL)
+        fatal("cannot create '%s': error %d %s\n", file, errno, strerror(errno));
+    setvbuf(em_capture_file, NULL, _IOFBF, 1 << 20);
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, EM_CAPTURE_MAGIC, sizeof(EM_CAPTURE_MAGIC));
+    h.version = EM_CAPTURE_VERSION;
+    fwrite(&h, sizeof(h), 1, em_capture_file);
+    clock_gettime(CLOCK_MONOTONIC, &em_capture_start);
+    atexit(em_capture_close);
+}
+
+/*
+ * appends a record to the binary capture, if any.
+ */
+void
+em_record(uint16_t type, uint16_t arg, void const *data, uint32_t len)
+{
+    static uint8_t const pad[8];
+    struct timespec now;
+    em_record_t r;
+
+    if (em_capture_file == NULL)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    r.time = (now.tv_sec - em_capture_start.tv_sec) * 1000000LL + (now.tv_nsec - em_capture_start.tv_nsec) / 1000;
+    r.len = len;
+    r.type = type;
+    r.arg = arg;
+    if ((fwrite(&r, sizeof(r), 1, em_capture_file) != 1) || (len && (fwrite(data, len, 1, em_capture_file) != 1)) ||
+        ((EM_ALIGN(len) > len) && (fwrite(pad, EM_ALIGN(len) - len, 1, em_capture_file) != 1))) {
+        warning("could not write capture: %d %s\n", errno, strerror(errno));
+        fclose(em_capture_file);
+        em_capture_file = NULL;
+    }
+}
+
+void
+em_replay_speed(double speed)
+{
+    em_speed = speed;
+}
+
+/*
+ * offline scan of recorded transport streams, see em_add_tsfile().
+ */
+static uint32_t em_ts_tp;            // em_tps index of file being read.
+static uint32_t em_ts_sections;      // sections stored from file being read.
+static uint64_t *em_ts_seen = NULL;  // sections stored already, open addressing.
+static uint32_t em_ts_seen_size = 0; // power of 2.
+static uint32_t em_ts_seen_count = 0;
+static uint8_t em_ts_pmt_pids[(TS_MAX_PID + 1) / 8];
+
+/*
+ * returns true, if key was seen before; adds it otherwise.
+ */
+static bool
+em_ts_seen_before(uint64_t key)
+{
+    uint32_t i;
+
+    key++; // 0 == empty slot.
+    if (2 * (em_ts_seen_count + 1) > em_ts_seen_size) {
+        uint64_t *old = em_ts_seen;
+        uint32_t old_size = em_ts_seen_size;
+
+        em_ts_seen_size = em_ts_seen_size ? 2 * em_ts_seen_size : 1024;
+        if ((em_ts_seen = calloc(em_ts_seen_size, sizeof(uint64_t))) == NULL)
+            fatal("%s: out of memory.\n", __FUNCTION__);
+        for (i = 0; i < old_size; i++) {
+            uint32_t h;
+
+            if (old[i] == 0)
+                continue;
+            for (h = (old[i] * 0x9E3779B97F4A7C15ULL) >> 40; em_ts_seen[h & (em_ts_seen_size - 1)]; h++)
+                ;
+            em_ts_seen[h & (em_ts_seen_size - 1)] = old[i];
+        }
+        free(old);
+    }
+    for (i = (key * 0x9E3779B97F4A7C15ULL) >> 40;; i++) {
+        uint64_t *slot = &em_ts_seen[i & (em_ts_seen_size - 1)];
+
+        if (*slot == key)
+            return true;
+        if (*slot == 0) {
+            *slot = key;
+            em_ts_seen_count++;
+            return false;
+        }
+    }
+}
+
+/*
+ * ts_demux callback: stores the first copy of each section, learns PMT pids from PAT.
+ */
+static void
+em_ts_section(uint16_t pid, unsigned char const *buf, int len)
+{
+    uint64_t key;
+    int i;
+
+    if ((len < 12) || !crc_check(buf, len))
+        return;
+    // pid, table_id, table_id_ext, section_number.
+    key = ((uint64_t)pid << 32) | ((uint32_t)buf[0] << 24) | (buf[3] << 16) | (buf[4] << 8) | buf[6];
+    if (em_ts_seen_before(key))
+        return;
+
+    if (buf[0] == TABLE_PAT) {
+        for (i = 8; i + 4 <= len - 4; i += 4) {
+            uint16_t program_number = (buf[i] << 8) | buf[i + 1];
+            uint16_t pmt_pid = ((buf[i + 2] & 0x1F) << 8) | buf[i + 3];
+
+            if (program_number != 0)
+                em_ts_pmt_pids[pmt_pid / 8] |= 1 << (pmt_pid % 8);
+        }
+    }
+    if (load_section(em_ts_tp, pid, buf, len, 0))
+        em_ts_sections++;
+}
+
+/*
+ * adds the PSI/SI sections of a recorded transport stream as emulated transponder t.
+ * Two passes over the mapped file: PAT, NIT, SDT and ATSC PSIP first, then all PMTs.
+ */
+void
+em_add_tsfile(char const *file, struct transponder *t)
+{
+    static uint16_t const si_pids[] = { 0x0000, 0x0010, 0x0011, 0x1FFB };
+    static struct ts_demux *d = NULL;
+    unsigned char const *map;
+    struct stat st;
+    uint32_t i;
+    int fd;
+
+    if (em_device.fe_info.name[0] == 0) {
+        // some device, which supports all of the files.
+        fe_delivery_system_t const delsystems[] = { SYS_ATSC, SYS_DVBS2, SYS_DVBS, SYS_DVBT2, SYS_DVBT, SYS_DVBC_ANNEX_A };
+
+        strcpy(em_device.fe_info.name, "transport stream files");
+        em_device.fe_info.frequency_min = 1;
+        em_device.fe_info.frequency_max = UINT32_MAX;
+        em_device.fe_info.symbol_rate_min = 1;
+        em_device.fe_info.symbol_rate_max = UINT32_MAX;
+        em_device.fe_info.caps = FE_CAN_INVERSION_AUTO | FE_CAN_FEC_AUTO | FE_CAN_QAM_AUTO | FE_CAN_TRANSMISSION_MODE_AUTO |
+                                 FE_CAN_GUARD_INTERVAL_AUTO | FE_CAN_HIERARCHY_AUTO | FE_CAN_2G_MODULATION;
+        memcpy(em_device.delsystems, delsystems, sizeof(delsystems));
+        em_device.ndelsystems = sizeof(delsystems) / sizeof(delsystems[0]);
+        em_api.major = DVB_API_VERSION;
+        em_api.minor = DVB_API_VERSION_MINOR;
+    }
+    if ((d == NULL) && ((d = ts_demux_alloc()) == NULL))
+        fatal("%s: out of memory.\n", __FUNCTION__);
+
+    if ((fd = open(file, O_RDONLY)) < 0)
+        fatal("cannot open '%s': error %d %s\n", file, errno, strerror(errno));
+    if (fstat(fd, &st) < 0)
+        fatal("cannot read '%s'.\n", file);
+    if (st.st_size == 0) {
+        close(fd);
+        warning("%s: empty file.\n", file);
+        return;
+    }
+    if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+        fatal("cannot mmap '%s': error %d %s\n", file, errno, strerror(errno));
+    close(fd);
+    madvise((void *)map, st.st_size, MADV_SEQUENTIAL);
+
+    em_ts_tp = em_find_tp(t);
+    em_ts_sections = 0;
+    memset(em_ts_seen, 0, em_ts_seen_size * sizeof(uint64_t));
+    em_ts_seen_count = 0;
+    memset(em_ts_pmt_pids, 0, sizeof(em_ts_pmt_pids));
+
+    for (i = 0; i < sizeof(si_pids) / sizeof(si_pids[0]); i++)
+        ts_demux_add_pid(d, si_pids[i]);
+    ts_demux_feed(d, map, st.st_size, em_ts_section);
+    for (i = 0; i < sizeof(si_pids) / sizeof(si_pids[0]); i++)
+        ts_demux_remove_pid(d, si_pids[i]);
+    d->fill = 0;
+
+    for (i = 0; i <= TS_MAX_PID; i++) {
+        if (em_ts_pmt_pids[i / 8] & (1 << (i % 8)))
+            ts_demux_add_pid(d, i);
+    }
+    if (d->active_pids > 0) {
+        ts_demux_feed(d, map, st.st_size, em_ts_section);
+        for (i = 0; i <= TS_MAX_PID; i++) {
+            if (em_ts_pmt_pids[i / 8] & (1 << (i % 8)))
+                ts_demux_remove_pid(d, i);
+        }
+        d->fill = 0;
+    }
+    munmap((void *)map, st.st_size);
+    info("%s: %u sections.\n", file, em_ts_sections);
+}
@@ -23,4 +23,22 @@ void em_polarization(uint8_t p);
 void em_addfilter(struct section_buf *s);
 void em_readfilters(int *result);
 
+//--------------------------------------------------
+/* record types of binary captures, see em_capture(). */
+enum em_record_type {
+    EM_REC_FE_INFO = 1,  // data: struct dvb_frontend_info
+    EM_REC_API_VERSION,  // arg: DVB API version
+    EM_REC_SET_PROPERTY, // data: struct dtv_property[]
+    EM_REC_GET_PROPERTY, // data: struct dtv_property[]
+    EM_REC_LNB,          // arg: high band, data: uint32_t high_val, low_val
+    EM_REC_POLARIZATION, // arg: polarization
+    EM_REC_STATUS,       // arg: fe_status_t
+    EM_REC_SECTION,      // arg: pid, data: section incl. header and CRC
+};
+
+void em_capture(char const *file);
+void em_record(uint16_t type, uint16_t arg, void const *data, uint32_t len);
+void em_replay_speed(double speed);
+void em_add_tsfile(char const *file, struct transponder *t);
+
 #endif
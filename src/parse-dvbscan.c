@@ -38,6 +38,7 @@
 #include "dvbscan.h"
 #include "satellites.h"
 #include "dump-vdr.h"
+#include "tp-index.h"
 
 #define MAX_LINE_LENGTH 1024 // paranoia, but still possible
 #define DELIMITERS    " \r\n\t"
@@ -338,6 +339,7 @@ dvbscan_parse_tuningdata(char const *tuningdata, struct w_scan_flags *flags)
         }
         free(copy);
         copy = NULL;
+        tp_index_update(tn); // frequency is known now.
         memset(buf, 0, sizeof(char) * MAX_LINE_LENGTH);
         print_transponder(buf, tn);
         info("\ttransponder %s\n", buf);
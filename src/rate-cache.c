@@ -0,0 +1,143 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+
+#include "rate-cache.h"
+#include "si_types.h"
+
+struct rate_entry {
+    /*----------------------------*/
+    void *prev;
+    void *next;
+    pList list;
+    /*----------------------------*/
+    uint16_t original_network_id;
+    uint16_t network_id;
+    uint8_t table_id;
+    bool measured; // interval was updated during this scan.
+    uint32_t interval; // msec
+};
+
+static cList _rate_entries, *rate_entries = NULL;
+
+static struct rate_entry *
+find_entry(uint16_t original_network_id, uint16_t network_id, uint8_t table_id, bool create)
+{
+    struct rate_entry *e;
+
+    if (rate_entries == NULL) {
+        rate_entries = &_rate_entries;
+        NewList(rate_entries, "rate_entries");
+    }
+    for (e = rate_entries->first; e; e = e->next) {
+        if ((e->original_network_id == original_network_id) && (e->network_id == network_id) && (e->table_id == table_id))
+            return e;
+    }
+    if (!create)
+        return NULL;
+
+    e = calloc(1, sizeof(struct rate_entry));
+    e->original_network_id = original_network_id;
+    e->network_id = network_id;
+    e->table_id = table_id;
+    AddItem(rate_entries, e);
+    return e;
+}
+
+/* returns the number of entries read, or -1 if the file could not be opened.
+ * A missing file is not an error, it's created by rate_cache_save().
+ */
+int
+rate_cache_load(char const *path)
+{
+    FILE *f;
+    char line[128];
+    int onid, nid, table_id;
+    unsigned interval;
+    int count = 0;
+
+    if ((f = fopen(path, "r")) == NULL) {
+        if (errno != ENOENT)
+            warning("could not read rate cache '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if ((line[0] == '#') || (line[0] == '\n'))
+            continue;
+        if ((sscanf(line, "%i %i %i %u", &onid, &nid, &table_id, &interval) != 4) || (onid < 0) || (onid > 0xFFFF) ||
+            (nid < 0) || (nid > 0xFFFF) || (table_id < 0) || (table_id > 0xFF) || (interval == 0)) {
+            verbose("rate cache '%s': skipping invalid line '%s'\n", path, line);
+            continue;
+        }
+        find_entry(onid, nid, table_id, true)->interval = interval;
+        count++;
+    }
+    fclose(f);
+    verbose("rate cache '%s': %d entries\n", path, count);
+    return count;
+}
+
+int
+rate_cache_save(char const *path)
+{
+    FILE *f;
+    struct rate_entry *e;
+
+    if (rate_entries == NULL)
+        return 0;
+    if ((f = fopen(path, "w")) == NULL) {
+        warning("could not write rate cache '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(f, "# w_scan2 SI repetition intervals\n");
+    fprintf(f, "# original_network_id network_id table_id msec\n");
+    for (e = rate_entries->first; e; e = e->next)
+        fprintf(f, "%u %u 0x%02x %u\n", e->original_network_id, e->network_id, e->table_id, e->interval);
+    fclose(f);
+    return 0;
+}
+
+uint32_t
+rate_cache_get(uint16_t original_network_id, uint16_t network_id, uint8_t table_id)
+{
+    struct rate_entry *e = find_entry(original_network_id, network_id, table_id, false);
+
+    return e ? e->interval : 0;
+}
+
+/* the first measurement of a scan replaces the cached value, so that a network
+ * which repeats its tables less often than before is noticed; within one scan
+ * the largest measured interval is kept.
+ */
+void
+rate_cache_put(uint16_t original_network_id, uint16_t network_id, uint8_t table_id, uint32_t interval)
+{
+    struct rate_entry *e = find_entry(original_network_id, network_id, table_id, true);
+
+    if (!e->measured || (interval > e->interval))
+        e->interval = interval;
+    e->measured = true;
+}
@@ -0,0 +1,42 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#ifndef __RATE_CACHE_H__
+#define __RATE_CACHE_H__
+
+#include <stdint.h>
+
+/*
+ * repetition intervals of SI tables, as measured per network (original_network_id, network_id).
+ * Kept for the whole scan; with --rate-cache persisted in a small text file between scans, one line per table:
+ *    <original_network_id> <network_id> <table_id> <interval in msec>
+ */
+
+int rate_cache_load(char const *path);
+int rate_cache_save(char const *path);
+
+/* returns the interval in msec, or 0 if unknown. */
+uint32_t rate_cache_get(uint16_t original_network_id, uint16_t network_id, uint8_t table_id);
+
+/* record an interval measured during this scan. */
+void rate_cache_put(uint16_t original_network_id, uint16_t network_id, uint8_t table_id, uint32_t interval);
+
+#endif
@@ -45,7 +45,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <signal.h>
@@ -72,6 +75,11 @@
 #include "diseqc.h"
 #include "iconv_codes.h"
 #include "char-coding.h"
+#include "ts-demux.h"
+#include "rate-cache.h"
+#include "si-cache.h"
+#include "tp-index.h"
+#include "backend.h"
 #include "si_types.h"
 #include "tools.h"
 
@@ -84,7 +92,7 @@
 #define em_static static
 #endif
 
-static char demux_devname[80];
+static __thread char demux_devname[80];
 
 struct w_scan_flags flags = {
     PACKAGE_VERSION, // readback value w_scan2 version
@@ -117,8 +125,8 @@ static unsigned int modulation_min = 0; // initialization of modulation loop. QA
 static unsigned int modulation_max = 1; // initialization of modulation loop. QAM256 if FE_QAM
 static unsigned int dvbc_symbolrate_min = 0; // initialization of symbolrate loop. 6900
 static unsigned int dvbc_symbolrate_max = 1; // initialization of symbolrate loop. 6875
-static unsigned int plp_id_min = 0; // initialization of plp_id loop.
-static unsigned int plp_id_max = 0; // initialization of plp_id loop.
+static __thread unsigned int plp_id_min = 0; // initialization of plp_id loop.
+static __thread unsigned int plp_id_max = 0; // initialization of plp_id loop.
 static unsigned int freq_offset_min = 0; // initialization of freq offset loop. 0 == offset (0), 1 == offset(+), 2 == offset(-),
                                          // 3 == offset1(+), 4 == offset2(+)
 static unsigned int freq_offset_max = 4; // initialization of freq offset loop.
@@ -163,7 +171,61 @@ static enum __output_format output_format = OUTPUT_VDR;
 
 cList _scanned_transponders, *scanned_transponders = &_scanned_transponders;
 cList _new_transponders, *new_transponders = &_new_transponders;
-static struct transponder *current_tp;
+
+/* scanned_transponders and new_transponders are indexed, see tp-index.h */
+static void
+add_tp(pList list, struct transponder *t)
+{
+    AddItem(list, t);
+    tp_index_add(t, list == scanned_transponders ? TP_INDEX_SCANNED : TP_INDEX_NEW);
+}
+
+static void
+unlink_tp(pList list, struct transponder *t)
+{
+    tp_index_remove(t);
+    UnlinkItem(list, t, false);
+}
+
+static void
+delete_tp(pList list, struct transponder *t)
+{
+    tp_index_remove(t);
+    free_service_table(t);
+    DeleteItem(list, t);
+}
+static __thread struct transponder *current_tp;
+
+/* --parallel: one worker thread per frontend, all sharing the transponder lists.
+ * Workers run one at a time holding scan_lock and release it only while waiting
+ * for the frontend or demux, see unlocked(). Everything a worker tunes or filters
+ * is thread local (__thread), everything it finds goes into the shared lists.
+ */
+struct scan_worker {
+    pthread_t thread;
+    int frontend_fd;
+    char demux_devname[80];
+    int tuning_data;
+};
+#define MAX_WORKERS 16 // one frontend per adapter, adapters 0..15 are auto detected.
+static struct scan_worker scan_workers[MAX_WORKERS];
+static int n_workers = 1; // 1 == no threads.
+static int parallel = -1; // --parallel N, -1 == off, 0 == all suitable frontends.
+static __thread int worker_index;
+static pthread_mutex_t scan_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t scan_cond = PTHREAD_COND_INITIALIZER; // new transponders or a worker became idle.
+static int busy_workers; // workers not waiting for new transponders.
+static int initial_tuning; // workers still in initial_tune().
+static struct transponder *initial_tp; // last transponder taken by initial_tune(), with tuning data.
+static int scanned_count; // transponders scanned by all workers.
+static bool auto_adapter; // --parallel needs adapter auto detection.
+
+#define unlocked(stmt)                    \
+    do {                                  \
+        pthread_mutex_unlock(&scan_lock); \
+        stmt;                             \
+        pthread_mutex_lock(&scan_lock);   \
+    } while (0)
 
 static void setup_filter(
     struct section_buf *s,
@@ -182,10 +244,22 @@ static void copy_fe_params(struct transponder *dest, struct transponder *source)
 // Thus we identify TPs by frequency (scan handles only one satellite at a time).
 // Further complication: Different NITs on one satellite sometimes list the same TP with slightly different
 // frequencies, so we have to search within some bandwidth.
+/* alloc_transponder(): same frequency, delivery system and polarization. */
+static bool
+is_same_frequency(struct transponder *tn, void *arg)
+{
+    struct transponder *t = arg;
+
+    if (tn->delsys != t->delsys)
+        return false;
+    if (tn->frequency != t->frequency)
+        return false;
+    return (t->type != SCAN_SATELLITE) || (t->polarization == tn->polarization);
+}
+
 struct transponder *
 alloc_transponder(uint32_t frequency, unsigned delsys, uint8_t polarization)
 {
-    struct transponder *tn;
     struct transponder *t = calloc(1, sizeof(*t));
     bool known = false;
     char name[20];
@@ -227,21 +301,11 @@ alloc_transponder(uint32_t frequency, unsigned delsys, uint8_t polarization)
 
     t->network_name = NULL;
 
-    if (frequency > 0) { // dont check, if we dont yet know freq.
-        for (tn = new_transponders->first; tn; tn = tn->next) {
-            if (tn->delsys != t->delsys)
-                continue;
-            if (tn->frequency == frequency) {
-                if ((t->type == SCAN_SATELLITE) && (polarization != tn->polarization))
-                    continue;
-                known = true;
-                break;
-            }
-        }
-    }
+    if (frequency > 0) // dont check, if we dont yet know freq.
+        known = tp_index_find_freq(frequency, NULL, TP_INDEX_NEW, is_same_frequency, t) != NULL;
 
     if (known == false) {
-        AddItem(new_transponders, t);
+        add_tp(new_transponders, t);
     }
     return t;
 }
@@ -431,6 +495,7 @@ copy_transponder(struct transponder *dest, struct transponder *source)
 
     dest->services = &(dest->_services);
     ClearList(dest->services);
+    free_service_table(dest);
 
     // be sure that we take all services from source to dest.
     for (s = (source->services)->first; s; s = s->next) {
@@ -439,7 +504,6 @@ copy_transponder(struct transponder *dest, struct transponder *source)
         sd->priv = NULL;
         sd->prev = NULL;
         sd->next = NULL;
-        sd->index = 0;
         AddItem(dest->services, sd);
     }
 
@@ -468,6 +532,48 @@ copy_transponder(struct transponder *dest, struct transponder *source)
         }
     } else
         dest->network_change.num_networks = 0;
+    tp_index_update(dest);
+}
+
+/* find_transponder_by_freq(): t matches tn by delivery system and frequency. */
+static bool
+is_tp_by_freq(struct transponder *t, void *arg)
+{
+    struct transponder *tn = arg;
+
+    if (t->delsys != tn->delsys)
+        return false;
+    if ((flags.scantype == SCAN_SATELLITE) && (t->polarization != tn->polarization))
+        return false;
+    if (flags.scantype == SCAN_TERRESTRIAL) {
+        struct cell *c;
+        int i;
+
+        for (c = (t->cells)->first; c; c = c->next) {
+            for (i = 0; i < c->num_center_frequencies; i++) {
+                // verbose("             checking t cell %u: center %7.3f\n", c->cell_id,
+                // c->center_frequencies[i]/1000000.0);
+                if (c->center_frequencies[i] == tn->frequency) {
+                    verbose("             matches tn center\n");
+                    return true;
+                }
+
+                struct cell *cn;
+                int j;
+                for (cn = (tn->cells)->first; cn; cn = cn->next) {
+                    for (j = 0; j < cn->num_center_frequencies; j++) {
+                        // verbose("             checking tn cell %u: center %7.3f\n", cn->cell_id,
+                        // cn->center_frequencies[j]/1000000.0);
+                        if (c->center_frequencies[i] == cn->center_frequencies[j]) {
+                            verbose("             matches tn center_frequencies[%d]\n", j);
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return is_nearly_same_frequency(t->frequency, tn->frequency, tn->type);
 }
 
 // TODO: remove this workaround.
@@ -487,86 +593,16 @@ find_transponder_by_freq(struct transponder *tn)
         return NULL; // delsys doesnt match
     }
 
-    for (t = scanned_transponders->first; t; t = t->next) {
-        if (t->delsys != tn->delsys)
-            continue;
-        if ((flags.scantype == SCAN_SATELLITE) && (t->polarization != tn->polarization))
-            continue;
-        if (flags.scantype == SCAN_TERRESTRIAL) {
-            struct cell *c;
-            int i;
-
-            for (c = (t->cells)->first; c; c = c->next) {
-                for (i = 0; i < c->num_center_frequencies; i++) {
-                    // verbose("             checking t cell %u: center %7.3f\n", c->cell_id,
-                    // c->center_frequencies[i]/1000000.0);
-                    if (c->center_frequencies[i] == tn->frequency) {
-                        verbose("             matches tn center\n");
-                        return t;
-                    }
-
-                    struct cell *cn;
-                    int j;
-                    for (cn = (tn->cells)->first; cn; cn = cn->next) {
-                        for (j = 0; j < cn->num_center_frequencies; j++) {
-                            // verbose("             checking tn cell %u: center %7.3f\n", cn->cell_id,
-                            // cn->center_frequencies[j]/1000000.0);
-                            if (c->center_frequencies[i] == cn->center_frequencies[j]) {
-                                verbose("             matches tn center_frequencies[%d]\n", j);
-                                return t;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        if (is_nearly_same_frequency(t->frequency, tn->frequency, tn->type)) {
-            print_transponder(buffer, t);
-            verbose("          -> found 'scanned_transponders(%.3u)'  %s\n", t->index, buffer);
-            free(buffer);
-            return t;
-        }
-    }
-
-    for (t = new_transponders->first; t; t = t->next) {
-        if (t->delsys != tn->delsys)
-            continue;
-        if ((flags.scantype == SCAN_SATELLITE) && (t->polarization != tn->polarization))
-            continue;
-        if (flags.scantype == SCAN_TERRESTRIAL) {
-            struct cell *c;
-            int i;
-
-            for (c = (t->cells)->first; c; c = c->next) {
-                for (i = 0; i < c->num_center_frequencies; i++) {
-                    // verbose("             checking t cell %u: center %7.3f\n", c->cell_id,
-                    // c->center_frequencies[i]/1000000.0);
-                    if (c->center_frequencies[i] == tn->frequency) {
-                        verbose("             matches tn center\n");
-                        return t;
-                    }
-
-                    struct cell *cn;
-                    int j;
-                    for (cn = (tn->cells)->first; cn; cn = cn->next) {
-                        for (j = 0; j < cn->num_center_frequencies; j++) {
-                            // verbose("             checking tn cell %u: center %7.3f\n", cn->cell_id,
-                            // cn->center_frequencies[j]/1000000.0);
-                            if (c->center_frequencies[i] == cn->center_frequencies[j]) {
-                                verbose("             matches tn center_frequencies[%d]\n", j);
-                                return t;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        if (is_nearly_same_frequency(t->frequency, tn->frequency, tn->type)) {
-            print_transponder(buffer, t);
-            verbose("          -> found 'new_transponders(%.3u)'  %s\n", t->index, buffer);
-            free(buffer);
-            return t;
-        }
+    t = tp_index_find_freq(tn->frequency, tn->cells, TP_INDEX_SCANNED | TP_INDEX_NEW, is_tp_by_freq, tn);
+    if (t != NULL) {
+        print_transponder(buffer, t);
+        verbose(
+            "          -> found '%s(%.3u)'  %s\n",
+            tp_index_list(t) == TP_INDEX_SCANNED ? "scanned_transponders" : "new_transponders",
+            GetIndex(tp_index_list(t) == TP_INDEX_SCANNED ? scanned_transponders : new_transponders, t),
+            buffer);
+        free(buffer);
+        return t;
     }
 
     // handle the case of current_tp not being in scanned_transponders or in new_transponders
@@ -575,7 +611,7 @@ find_transponder_by_freq(struct transponder *tn)
             verbose("          -> found current_tp'  %s\n", buffer);
             t = calloc(1, sizeof(*t));
             copy_transponder(t, tn);
-            AddItem(scanned_transponders, t);
+            add_tp(scanned_transponders, t);
             free(buffer);
             return current_tp;
         }
@@ -588,6 +624,15 @@ find_transponder_by_freq(struct transponder *tn)
 
 void list_transponders();
 
+/* find_transponder(): network_id and transport_stream_id are already matched by the index. */
+static bool
+is_tp_by_onid(struct transponder *t, void *arg)
+{
+    uint16_t original_network_id = *(uint16_t *)arg;
+
+    return !t->original_network_id || (t->original_network_id == original_network_id);
+}
+
 /* 300468 p22 5.2.1 NIT:  "The combination of original_network_id and transport_stream_id allow each TS to be
    uniquely identified throughout the application area of the present document." */
 static struct transponder *
@@ -595,7 +640,6 @@ find_transponder(uint16_t original_network_id, uint16_t network_id, uint16_t tra
 {
     struct transponder *t;
     char buf[128];
-    int check_onid = original_network_id > 0;
 
     verbose("	%s(%u:%u:%u):", __FUNCTION__, original_network_id, network_id, transport_stream_id);
 
@@ -603,28 +647,21 @@ find_transponder(uint16_t original_network_id, uint16_t network_id, uint16_t tra
         return NULL;
 
     if (original_network_id != 0) {
-        for (t = scanned_transponders->first; t; t = t->next) {
-            if (check_onid && t->original_network_id) {
-                if (t->original_network_id != original_network_id)
-                    continue;
-            }
-
-            if ((t->transport_stream_id == transport_stream_id) && (t->network_id == network_id)) {
-                print_transponder(buf, t);
-                verbose("          -> found 'scanned_transponders(%.3u)'  %s (line %d)\n", t->index, buf, __LINE__);
-                return t;
-            }
-        }
-        for (t = new_transponders->first; t; t = t->next) {
-            if (check_onid && t->original_network_id) {
-                if (t->original_network_id != original_network_id)
-                    continue;
-            }
-            if ((t->transport_stream_id == transport_stream_id) && (t->network_id == network_id)) {
-                print_transponder(buf, t);
-                verbose("          -> found 'new_transponders(%.3u)'  %s (line %d)\n", t->index, buf, __LINE__);
-                return t;
-            }
+        t = tp_index_find_id(
+            network_id,
+            transport_stream_id,
+            TP_INDEX_SCANNED | TP_INDEX_NEW,
+            is_tp_by_onid,
+            &original_network_id);
+        if (t != NULL) {
+            print_transponder(buf, t);
+            verbose(
+                "          -> found '%s(%.3u)'  %s (line %d)\n",
+                tp_index_list(t) == TP_INDEX_SCANNED ? "scanned_transponders" : "new_transponders",
+                GetIndex(tp_index_list(t) == TP_INDEX_SCANNED ? scanned_transponders : new_transponders, t),
+                buf,
+                __LINE__);
+            return t;
         }
     }
 
@@ -632,33 +669,55 @@ find_transponder(uint16_t original_network_id, uint16_t network_id, uint16_t tra
     return NULL;
 }
 
+static bool
+is_tp_by_onid_strict(struct transponder *t, void *arg)
+{
+    return t->original_network_id == *(uint16_t *)arg;
+}
+
+/* SDT-other and BAT: transport streams are identified by original_network_id and transport_stream_id only. */
+static struct transponder *
+find_transponder_by_ts(uint16_t original_network_id, uint16_t transport_stream_id)
+{
+    if ((original_network_id == 0) || (transport_stream_id == 0))
+        return NULL;
+    return tp_index_find_ts(transport_stream_id, TP_INDEX_SCANNED | TP_INDEX_NEW, is_tp_by_onid_strict, &original_network_id);
+}
+
+struct initial_tp_query {
+    struct transponder *tn;
+    int auto_allowed;
+};
+
+/* is_known_initial_transponder(): t is the same transponder as tn. */
+static bool
+is_same_initial_tp(struct transponder *t, void *arg)
+{
+    struct initial_tp_query *q = arg;
+    struct transponder *tn = q->tn;
+
+    switch (tn->type) {
+    case SCAN_TERRESTRIAL:
+    case SCAN_CABLE:
+        return (t->type == tn->type) && is_nearly_same_frequency(t->frequency, tn->frequency, t->type);
+    case SCAN_TERRCABLE_ATSC:
+        return (t->type == tn->type) && is_nearly_same_frequency(t->frequency, tn->frequency, t->type) &&
+               (t->modulation == tn->modulation);
+    case SCAN_SATELLITE:
+        return !is_different_transponder_deep_scan(tn, t, q->auto_allowed);
+    default:
+        fatal("Unhandled type %d\n", tn->type);
+    }
+}
+
 /* identify wether tn is already in list of new transponders */
 static int
 is_known_initial_transponder(struct transponder *tn, int auto_allowed)
 {
-    struct transponder *t;
+    struct initial_tp_query q = { tn, auto_allowed };
+    struct transponder *t = tp_index_find_freq(tn->frequency, NULL, TP_INDEX_NEW, is_same_initial_tp, &q);
 
-    for (t = new_transponders->first; t; t = t->next) {
-        switch (tn->type) {
-        case SCAN_TERRESTRIAL:
-        case SCAN_CABLE:
-            if ((t->type == tn->type) && is_nearly_same_frequency(t->frequency, tn->frequency, t->type))
-                return (t->source >> 8) == TABLE_NIT_ACT;
-            break;
-        case SCAN_TERRCABLE_ATSC:
-            if ((t->type == tn->type) && is_nearly_same_frequency(t->frequency, tn->frequency, t->type) &&
-                (t->modulation == tn->modulation))
-                return (t->source >> 8) == TABLE_NIT_ACT;
-            break;
-        case SCAN_SATELLITE:
-            if (!is_different_transponder_deep_scan(tn, t, auto_allowed))
-                return (t->source >> 8) == TABLE_NIT_ACT;
-            break;
-        default:
-            fatal("Unhandled type %d\n", tn->type);
-        }
-    }
-    return 0;
+    return t ? (t->source >> 8) == TABLE_NIT_ACT : 0;
 }
 
 void
@@ -739,16 +798,17 @@ list_transponders()
         return;
     struct transponder *t;
     char buf[128];
+    uint32_t i;
 
     verbose("          ================= %s() =======================\n", __FUNCTION__);
-    for (t = scanned_transponders->first; t; t = t->next) {
+    for (t = scanned_transponders->first, i = 0; t; t = t->next, i++) {
         print_transponder(buf, t);
-        verbose("          %s(%.3u): %s\n", scanned_transponders->name, t->index, buf);
+        verbose("          %s(%.3u): %s\n", scanned_transponders->name, i, buf);
     }
 
-    for (t = new_transponders->first; t; t = t->next) {
+    for (t = new_transponders->first, i = 0; t; t = t->next, i++) {
         print_transponder(buf, t);
-        verbose("          %s(%.3u): %s\n", new_transponders->name, t->index, buf);
+        verbose("          %s(%.3u): %s\n", new_transponders->name, i, buf);
     }
     verbose("          =============================================================\n");
 }
@@ -775,88 +835,104 @@ copy_duplicate_tp(struct transponder *t, struct transponder *t2)
             t->frequency = last_freq;
         }
     }
+    tp_index_update(t);
     // enshure that current_tp points to valid tp.
     if (current_tp == t2)
         current_tp = t;
 }
 
-void
-check_duplicate_transponders()
+static bool
+is_duplicate_tp(struct transponder *t2, void *arg)
+{
+    struct transponder *t = arg;
+
+    if ((t2 == t) || (t2->delsys != t->delsys))
+        return false;
+    return !t->original_network_id || !t2->original_network_id || (t->original_network_id == t2->original_network_id);
+}
+
+/* merges t with all transponders of same delsys, original_network_id, network_id and transport_stream_id
+ * by copy_duplicate_tp(); the first one in list order is kept, all others are deleted.
+ * Called whenever t was added or its ids changed, therefore there are no other duplicates than those of t.
+ * Transponders in neither list are not merged. Returns the kept transponder.
+ */
+static struct transponder *
+check_duplicate_transponder(struct transponder *t)
 {
-    struct transponder *t, *t2;
+    struct transponder *t2, *keep, *dup;
     char buf[128];
+    pList list;
 
     verbose("          %s()\n", __FUNCTION__);
-    for (t = scanned_transponders->first; t; t = t->next) {
-        for (t2 = t->next; t2; t2 = t2->next) {
-            if (t->delsys != t2->delsys)
-                continue;
-            if (t->original_network_id && t2->original_network_id) {
-                if (t->original_network_id != t2->original_network_id)
-                    continue;
-            }
-            if (t->network_id != t2->network_id)
-                continue;
-            if (t->transport_stream_id != t2->transport_stream_id)
-                continue;
-            copy_duplicate_tp(t, t2);
-            print_transponder(buf, t2);
-            verbose(
-                "          DELETING DUPLICATE TRANSPONDER %s(%.3u): %s (line:%d)\n",
-                scanned_transponders->name,
-                t2->index,
-                buf,
-                __LINE__);
-            DeleteItem(scanned_transponders, t2);
-            return;
-        }
-        for (t2 = new_transponders->first; t2; t2 = t2->next) {
-            if (t->delsys != t2->delsys)
-                continue;
-            if (t->original_network_id && t2->original_network_id) {
-                if (t->original_network_id != t2->original_network_id)
-                    continue;
-            }
-            if (t->network_id != t2->network_id)
-                continue;
-            if (t->transport_stream_id != t2->transport_stream_id)
-                continue;
-            copy_duplicate_tp(t, t2);
-            print_transponder(buf, t2);
-            verbose(
-                "          DELETING DUPLICATE TRANSPONDER %s(%.3u): %s (line:%d)\n",
-                new_transponders->name,
-                t2->index,
-                buf,
-                __LINE__);
-            DeleteItem(new_transponders, t2);
-            return;
-        }
-    }
-    for (t = new_transponders->first; t; t = t->next) {
-        for (t2 = t->next; t2; t2 = t2->next) {
-            if (t->delsys != t2->delsys)
-                continue;
-            if (t->original_network_id && t2->original_network_id) {
-                if (t->original_network_id != t2->original_network_id)
-                    continue;
-            }
-            if (t->network_id != t2->network_id)
-                continue;
-            if (t->transport_stream_id != t2->transport_stream_id)
-                continue;
-            copy_duplicate_tp(t, t2);
-            print_transponder(buf, t2);
-            verbose(
-                "          DELETING DUPLICATE TRANSPONDER %s(%.3u): %s (line:%d)\n",
-                new_transponders->name,
-                t2->index,
-                buf,
-                __LINE__);
-            DeleteItem(new_transponders, t2);
-            return;
+    if (!t->network_id && !t->transport_stream_id)
+        return t; // not yet identified.
+    if (t->tp_index == NULL)
+        return t; // in no list, e.g. current_tp on a frequency scanned before: never replaces a listed one.
+
+    while ((t2 = tp_index_find_id(t->network_id, t->transport_stream_id, TP_INDEX_SCANNED | TP_INDEX_NEW, is_duplicate_tp, t))) {
+        if (tp_index_before(t2, t)) {
+            keep = t2;
+            dup = t;
+        } else {
+            keep = t;
+            dup = t2;
         }
+        list = tp_index_list(dup) == TP_INDEX_SCANNED ? scanned_transponders : new_transponders;
+        copy_duplicate_tp(keep, dup);
+        print_transponder(buf, dup);
+        verbose(
+            "          DELETING DUPLICATE TRANSPONDER %s(%.3u): %s (line:%d)\n",
+            list->name,
+            GetIndex(list, dup),
+            buf,
+            __LINE__);
+        delete_tp(list, dup);
+        t = keep;
     }
+    return t;
+}
+
+/* t->service_table: open addressing by service_id w/ linear probing, at most half filled.
+ * Holds the services of t->services in list order, so that duplicate service_ids are found as
+ * in the list. Services are never removed one by one; if the list was changed otherwise than by
+ * alloc_service(), the table is rebuilt from the list on next use.
+ */
+#define SERVICE_SLOT(service_id, size) ((((service_id) * 0x9E3779B1U) >> 16) & ((size) - 1))
+
+void
+free_service_table(struct transponder *t)
+{
+    free(t->service_table);
+    t->service_table = NULL;
+    t->service_table_size = 0;
+    t->service_table_count = 0;
+}
+
+static void
+service_table_insert(struct transponder *t, struct service *s)
+{
+    uint32_t i = SERVICE_SLOT(s->service_id, t->service_table_size);
+
+    while (t->service_table[i] != NULL)
+        i = (i + 1) & (t->service_table_size - 1);
+    t->service_table[i] = s;
+    t->service_table_count++;
+}
+
+static void
+service_table_rebuild(struct transponder *t)
+{
+    struct service *s;
+    uint32_t size = 16;
+
+    while (size < 2 * ((t->services)->count + 1))
+        size *= 2;
+    free(t->service_table);
+    t->service_table = calloc(size, sizeof(struct service *));
+    t->service_table_size = size;
+    t->service_table_count = 0;
+    for (s = (t->services)->first; s; s = s->next)
+        service_table_insert(t, s);
 }
 
 /* service_ids are guaranteed to be unique within one TP
@@ -869,6 +945,12 @@ alloc_service(struct transponder *t, uint16_t service_id)
     s->service_id = service_id;
     s->transponder = t;
     AddItem(t->services, s);
+    if (t->service_table_count + 1 != (t->services)->count)
+        return s; // out of sync anyway, see find_service().
+    if (2 * (t->services)->count > t->service_table_size)
+        service_table_rebuild(t);
+    else
+        service_table_insert(t, s);
     return s;
 }
 
@@ -876,52 +958,67 @@ struct service *
 find_service(struct transponder *t, uint16_t service_id)
 {
     struct service *s;
+    uint32_t i, mask;
 
-    for (s = (t->services)->first; s; s = s->next) {
+    if (t->service_table_count != (t->services)->count)
+        service_table_rebuild(t);
+    if (t->service_table_size == 0)
+        return NULL;
+
+    mask = t->service_table_size - 1;
+    for (i = SERVICE_SLOT(service_id, t->service_table_size); (s = t->service_table[i]); i = (i + 1) & mask) {
         if (s->service_id == service_id)
             return s;
     }
     return NULL;
 }
 
-static int
-find_descriptor(uint8_t tag, unsigned char const *buf, int descriptors_loop_len, unsigned char const **desc, int *desc_len)
-{
-    while (descriptors_loop_len > 0) {
-        unsigned char descriptor_tag = buf[0];
-        unsigned char descriptor_len = buf[1] + 2;
+/* descriptor tags, which are parsed but not needed for the current output format; see init_descriptor_filter() */
+static uint32_t skipped_descriptors[DESCRIPTOR_SET_WORDS];
 
-        if (!descriptor_len) {
-            warning("descriptor_tag == 0x%02x, len is 0\n", descriptor_tag);
-            break;
-        }
+static void
+init_descriptor_filter(void)
+{
+    memset(skipped_descriptors, 0, sizeof(skipped_descriptors));
+    if ((output_format == OUTPUT_VDR) || (output_format == OUTPUT_XML) || (verbosity > 3))
+        return;
+    // CA system ids, audio and subtitling languages are written by vdr and xml output only.
+    descriptor_set_add(skipped_descriptors, ca_descriptor);
+    descriptor_set_add(skipped_descriptors, ca_identifier_descriptor);
+    descriptor_set_add(skipped_descriptors, content_descriptor);
+    descriptor_set_add(skipped_descriptors, parental_rating_descriptor);
+    descriptor_set_add(skipped_descriptors, teletext_descriptor);
+    descriptor_set_add(skipped_descriptors, telephone_descriptor);
+    descriptor_set_add(skipped_descriptors, local_time_offset_descriptor);
+    descriptor_set_add(skipped_descriptors, subtitling_descriptor);
+    if (verbosity < 5) // audio languages are printed by parse_pmt() in debug mode.
+        descriptor_set_add(skipped_descriptors, iso_639_language_descriptor);
+}
 
-        if (tag == descriptor_tag) {
-            if (desc)
-                *desc = buf;
-            if (desc_len)
-                *desc_len = descriptor_len;
-            return 1;
-        }
+/* collects the tags of a descriptor loop, so that several tags can be looked up w/o walking the loop again. */
+static void
+get_descriptor_tags(unsigned char const *buf, int descriptors_loop_len, uint32_t *tags)
+{
+    struct descriptor_iter it;
+    struct descriptor d;
 
-        buf += descriptor_len;
-        descriptors_loop_len -= descriptor_len;
-    }
-    return 0;
+    memset(tags, 0, DESCRIPTOR_SET_WORDS * sizeof(uint32_t));
+    descriptor_iter_init(&it, buf, descriptors_loop_len, NULL);
+    while (descriptor_next(&it, &d))
+        descriptor_set_add(tags, d.tag);
 }
 
 static void
 parse_descriptors(enum table_id t, unsigned char const *buf, int descriptors_loop_len, void *data, scantype_t scantype)
 {
-    while (descriptors_loop_len > 0) {
-        unsigned char descriptor_tag = buf[0];
-        unsigned char descriptor_len = buf[1] + 2;
+    struct descriptor_iter it;
+    struct descriptor d;
 
-        if (descriptor_len == 0) {
-            debug("descriptor_tag == 0x%02x, len is 0\n", descriptor_tag);
-            break;
-        }
+    descriptor_iter_init(&it, buf, descriptors_loop_len, skipped_descriptors);
+    while (descriptor_next(&it, &d)) {
+        unsigned char descriptor_tag = d.tag;
 
+        buf = d.buf;
         switch (descriptor_tag) {
         case MHP_application_descriptor:
         case MHP_application_name_desriptor:
@@ -948,7 +1045,7 @@ parse_descriptors(enum table_id t, unsigned char const *buf, int descriptors_loo
         case stuffing_descriptor:
             break;
         case satellite_delivery_system_descriptor:
-            if ((scantype == SCAN_SATELLITE) && ((t == TABLE_NIT_ACT) || (t == TABLE_NIT_OTH)))
+            if ((scantype == SCAN_SATELLITE) && ((t == TABLE_NIT_ACT) || (t == TABLE_NIT_OTH) || (t == TABLE_FASTSCAN_FNT)))
                 parse_satellite_delivery_system_descriptor(buf, data, caps_inversion);
             break;
         case cable_delivery_system_descriptor:
@@ -984,7 +1081,8 @@ parse_descriptors(enum table_id t, unsigned char const *buf, int descriptors_loo
         case telephone_descriptor:
         case local_time_offset_descriptor:
         case subtitling_descriptor:
-            parse_subtitling_descriptor(buf, data);
+            if ((t == TABLE_PMT) || (t == TABLE_SDT_ACT) || (t == TABLE_SDT_OTH)) // data is a service here.
+                parse_subtitling_descriptor(buf, data);
             break;
         case terrestrial_delivery_system_descriptor:
             if ((scantype == SCAN_TERRESTRIAL) && ((t == TABLE_NIT_ACT) || (t == TABLE_NIT_OTH)))
@@ -1063,7 +1161,7 @@ parse_descriptors(enum table_id t, unsigned char const *buf, int descriptors_loo
         case ecm_repetition_rate_descriptor:
             break;
         case s2_satellite_delivery_system_descriptor:
-            if ((scantype == SCAN_SATELLITE) && ((t == TABLE_NIT_ACT) || (t == TABLE_NIT_OTH)) &&
+            if ((scantype == SCAN_SATELLITE) && ((t == TABLE_NIT_ACT) || (t == TABLE_NIT_OTH) || (t == TABLE_FASTSCAN_FNT)) &&
                 (fe_info.caps & FE_CAN_2G_MODULATION))
                 parse_S2_satellite_delivery_system_descriptor(buf, data);
             break;
@@ -1080,9 +1178,6 @@ parse_descriptors(enum table_id t, unsigned char const *buf, int descriptors_loo
         default:
             verbosedebug("skip descriptor 0x%02x\n", descriptor_tag);
         }
-
-        buf += descriptor_len;
-        descriptors_loop_len -= descriptor_len;
     }
 }
 
@@ -1105,8 +1200,9 @@ parse_pat(unsigned char const *buf, uint16_t section_length, uint16_t transport_
                 current_tp->network_id,
                 transport_stream_id);
             current_tp->transport_stream_id = transport_stream_id;
+            tp_index_update(current_tp);
             if (flags.delete_duplicate_transponders) {
-                check_duplicate_transponders();
+                check_duplicate_transponder(current_tp);
             }
             if (verbosity > 1)
                 list_transponders();
@@ -1152,6 +1248,7 @@ em_static void
 parse_pmt(unsigned char const *buf, uint16_t section_length, uint16_t service_id)
 {
     int program_info_len;
+    int len = section_length;
     struct service *s;
     char msg_buf[14 * AUDIO_CHAN_MAX + 1];
     char *tmp;
@@ -1169,19 +1266,22 @@ parse_pmt(unsigned char const *buf, uint16_t section_length, uint16_t service_id
 
     // 20080106, search PMT program info for CA Ids
     buf += 4;
-    section_length -= 4;
-
-    while (program_info_len > 0) {
-        int descriptor_length = ((int)buf[1]) + 2;
-        parse_descriptors(TABLE_PMT, buf, section_length, s, flags.scantype);
-        buf += descriptor_length;
-        section_length -= descriptor_length;
-        program_info_len -= descriptor_length;
-    }
-
-    while (section_length > 0) {
+    len -= 4;
+    if (program_info_len > len)
+        program_info_len = len;
+    parse_descriptors(TABLE_PMT, buf, program_info_len, s, flags.scantype);
+    buf += program_info_len;
+    len -= program_info_len;
+
+    while (len >= 5) {
         int ES_info_len = ((buf[3] & 0x0f) << 8) | buf[4];
         int elementary_pid = ((buf[1] & 0x1f) << 8) | buf[2];
+        uint32_t tags[DESCRIPTOR_SET_WORDS];
+
+        if (ES_info_len > len - 5) {
+            verbose("PMT: ES_info_length %d exceeds section, truncating\n", ES_info_len);
+            ES_info_len = len - 5;
+        }
 
         switch (buf[0]) { // stream type
         case iso_iec_11172_video_stream:
@@ -1206,11 +1306,12 @@ parse_pmt(unsigned char const *buf, uint16_t section_length, uint16_t service_id
         case iso_iec_13818_1_private_sections:
         case iso_iec_13818_1_private_data:
             // ITU-T Rec. H.222.0 | ISO/IEC 13818-1 PES packets containing private data
-            if (find_descriptor(teletext_descriptor, buf + 5, ES_info_len, NULL, NULL)) {
+            get_descriptor_tags(buf + 5, ES_info_len, tags);
+            if (descriptor_set_has(tags, teletext_descriptor)) {
                 moreverbose("  TELETEXT  : PID %d\n", elementary_pid);
                 s->teletext_pid = elementary_pid;
                 break;
-            } else if (find_descriptor(subtitling_descriptor, buf + 5, ES_info_len, NULL, NULL)) {
+            } else if (descriptor_set_has(tags, subtitling_descriptor)) {
                 // Note: The subtitling descriptor can also signal
                 // teletext subtitling, but then the teletext descriptor
                 // will also be present; so we can be quite confident
@@ -1219,7 +1320,7 @@ parse_pmt(unsigned char const *buf, uint16_t section_length, uint16_t service_id
                 moreverbose("  SUBTITLING: PID %d\n", elementary_pid);
                 s->subtitling_pid[s->subtitling_num++] = elementary_pid;
                 break;
-            } else if (find_descriptor(ac3_descriptor, buf + 5, ES_info_len, NULL, NULL)) {
+            } else if (descriptor_set_has(tags, ac3_descriptor)) {
                 moreverbose("  AC3       : PID %d (stream type 0x%x)\n", elementary_pid, buf[0]);
                 if (s->ac3_num < AC3_CHAN_MAX) {
                     s->ac3_pid[s->ac3_num] = elementary_pid;
@@ -1229,7 +1330,7 @@ parse_pmt(unsigned char const *buf, uint16_t section_length, uint16_t service_id
                 } else
                     warning("more than %i ac3 audio channels, truncating\n", AC3_CHAN_MAX);
                 break;
-            } else if (find_descriptor(enhanced_ac3_descriptor, buf + 5, ES_info_len, NULL, NULL)) {
+            } else if (descriptor_set_has(tags, enhanced_ac3_descriptor)) {
                 moreverbose("  EAC3      : PID %d (stream type 0x%x)\n", elementary_pid, buf[0]);
                 if (s->ac3_num < AC3_CHAN_MAX) {
                     s->ac3_pid[s->ac3_num] = elementary_pid;
@@ -1387,7 +1488,7 @@ parse_pmt(unsigned char const *buf, uint16_t section_length, uint16_t service_id
             moreverbose("  OTHER     : PID %d TYPE 0x%02x\n", elementary_pid, buf[0]);
         } // END switch stream type
         buf += ES_info_len + 5;
-        section_length -= ES_info_len + 5;
+        len -= ES_info_len + 5;
     }
 
     tmp = msg_buf;
@@ -1431,8 +1532,9 @@ parse_nit(unsigned char const *buf, uint16_t section_length, uint8_t table_id, u
             network_id,
             current_tp->transport_stream_id);
         current_tp->network_id = network_id;
+        tp_index_update(current_tp);
         if (flags.delete_duplicate_transponders) {
-            check_duplicate_transponders();
+            check_duplicate_transponder(current_tp);
         }
         if (verbosity > 1)
             list_transponders();
@@ -1449,6 +1551,7 @@ parse_nit(unsigned char const *buf, uint16_t section_length, uint8_t table_id, u
     }
     // update network_name
     parse_descriptors(table_id, buf + 2, descriptors_loop_len, current_tp, flags.scantype);
+    tp_index_update(current_tp);
     section_length -= descriptors_loop_len + 4;
     buf += descriptors_loop_len + 4;
 
@@ -1536,10 +1639,11 @@ parse_nit(unsigned char const *buf, uint16_t section_length, uint8_t table_id, u
                         t->original_network_id = original_network_id;
                         t->network_id = network_id;
                         t->transport_stream_id = transport_stream_id;
+                        tp_index_update(t);
                         if (verbosity > 1)
                             list_transponders();
                         if (flags.delete_duplicate_transponders) {
-                            check_duplicate_transponders();
+                            t = check_duplicate_transponder(t);
                         }
                     }
                 }
@@ -1601,7 +1705,7 @@ parse_nit(unsigned char const *buf, uint16_t section_length, uint8_t table_id, u
                         }
                     }
                     if (flags.delete_duplicate_transponders) {
-                        check_duplicate_transponders();
+                        t = check_duplicate_transponder(t);
                     }
                     if (verbosity > 1)
                         list_transponders();
@@ -1609,19 +1713,58 @@ parse_nit(unsigned char const *buf, uint16_t section_length, uint8_t table_id, u
             }
         }
         ClearList(tn.services);
+        free_service_table(&tn);
 
         section_length -= descriptors_loop_len + 6;
         buf += descriptors_loop_len + 6;
     }
 }
 
-em_static void
-parse_sdt(unsigned char const *buf, uint16_t section_length, uint16_t transport_stream_id)
+/* parse_nit() applies LCNs and network change notifications of a NIT-other
+ * section to current_tp; otherwise it changes only the transponder lists and
+ * current_tp->source, if the section has a transport stream loop (*source != 0).
+ */
+static bool
+nit_other_is_context_free(unsigned char const *buf, int section_length, uint32_t *source)
 {
-    hexdump(__FUNCTION__, buf, section_length);
+    int descriptors_loop_len = ((buf[0] & 0x0f) << 8) | buf[1];
+    struct descriptor_iter it;
+    struct descriptor d;
+
+    *source = 0;
+    if (section_length < descriptors_loop_len + 4)
+        return true; // not parsed at all.
+
+    descriptor_iter_init(&it, buf + 2, descriptors_loop_len, NULL);
+    while (descriptor_next(&it, &d)) {
+        if (d.tag == logical_channel_descriptor)
+            return false;
+        if ((d.tag == extension_descriptor) && d.length && (d.buf[2] == network_change_notify_descriptor))
+            return false;
+    }
+    section_length -= descriptors_loop_len + 4;
+    buf += descriptors_loop_len + 4;
 
-    buf += 3; /*  skip original network id + reserved field */
+    while (section_length > 6) {
+        descriptors_loop_len = ((buf[4] << 8) | buf[5]) & 0x0FFF;
+        if (section_length < descriptors_loop_len + 4)
+            break;
+        *source = 1;
+        descriptor_iter_init(&it, buf + 6, descriptors_loop_len, NULL);
+        while (descriptor_next(&it, &d)) {
+            if (d.tag == logical_channel_descriptor)
+                return false;
+        }
+        section_length -= descriptors_loop_len + 6;
+        buf += descriptors_loop_len + 6;
+    }
+    return true;
+}
 
+/* service loop of SDT-actual or SDT-other, services of t. */
+static void
+parse_sdt_services(struct transponder *t, enum table_id table_id, unsigned char const *buf, int section_length)
+{
     while (section_length > 4) {
         int service_id = (buf[0] << 8) | buf[1];
         int descriptors_loop_len = ((buf[3] & 0x0f) << 8) | buf[4];
@@ -1637,15 +1780,15 @@ parse_sdt(unsigned char const *buf, uint16_t section_length, uint16_t transport_
             break;
         }
 
-        s = find_service(current_tp, service_id);
+        s = find_service(t, service_id);
         if (!s)
             /* maybe PAT has not yet been parsed... */
-            s = alloc_service(current_tp, service_id);
+            s = alloc_service(t, service_id);
 
         s->running = (buf[3] >> 5) & 0x7;
         s->scrambled = (buf[3] >> 4) & 1;
 
-        parse_descriptors(TABLE_SDT_ACT, buf + 5, descriptors_loop_len, s, flags.scantype);
+        parse_descriptors(table_id, buf + 5, descriptors_loop_len, s, flags.scantype);
 
         section_length -= descriptors_loop_len + 5;
         buf += descriptors_loop_len + 5;
@@ -1653,28 +1796,253 @@ parse_sdt(unsigned char const *buf, uint16_t section_length, uint16_t transport_
 }
 
 em_static void
-parse_psip_descriptors(struct service *s, unsigned char const *buf, int len)
+parse_sdt(unsigned char const *buf, uint16_t section_length, uint16_t transport_stream_id)
 {
-    unsigned char *b = (unsigned char *)buf;
-    int descriptor_length;
+    hexdump(__FUNCTION__, buf, section_length);
 
-    hexdump(__FUNCTION__, buf, len);
+    buf += 3; /*  skip original network id + reserved field */
 
-    while (len > 0) {
-        descriptor_length = b[1];
-        switch (b[0]) {
-        case atsc_service_location_descriptor:
-            parse_atsc_service_location_descriptor(s, b);
-            break;
-        case atsc_extended_channel_name_descriptor:
-            parse_atsc_extended_channel_name_descriptor(s, b);
-            break;
-        default:
-            warning("unhandled psip descriptor: %02x\n", b[0]);
-            break;
+    parse_sdt_services(current_tp, TABLE_SDT_ACT, buf, section_length);
+}
+
+/* SDT-other: services of the other transport streams of this network, which
+ * are known from NIT. Their transponders may be not yet tuned or never, see --quick.
+ */
+em_static void
+parse_sdt_other(unsigned char const *buf, uint16_t section_length, uint16_t transport_stream_id)
+{
+    uint16_t original_network_id = (buf[0] << 8) | buf[1];
+    struct transponder *t = find_transponder_by_ts(original_network_id, transport_stream_id);
+
+    hexdump(__FUNCTION__, buf, section_length);
+
+    if ((t == NULL) || (t == current_tp)) {
+        verbose("        SDT(oth): skipping transport stream (%u:xxxx:%u)\n", original_network_id, transport_stream_id);
+        return;
+    }
+    parse_sdt_services(t, TABLE_SDT_OTH, buf + 3, section_length);
+}
+
+/* BAT: services and logical channel numbers of one bouquet, which may span
+ * several networks. The services of the bouquet are added to the transport
+ * streams known from NIT, names and ids come with SDT.
+ */
+static void
+parse_bat(unsigned char const *buf, uint16_t section_length, uint16_t bouquet_id)
+{
+    int len = section_length;
+    int descriptors_loop_len = ((buf[0] & 0x0f) << 8) | buf[1];
+    struct descriptor_iter it;
+    struct descriptor d;
+
+    hexdump(__FUNCTION__, buf, section_length);
+
+    if (len < descriptors_loop_len + 4)
+        return;
+    descriptor_iter_init(&it, buf + 2, descriptors_loop_len, NULL);
+    while (descriptor_next(&it, &d)) {
+        if (d.tag == bouquet_name_descriptor)
+            verbose("        BAT: bouquet %u '%.*s'\n", bouquet_id, d.length, d.buf + 2);
+    }
+    len -= descriptors_loop_len + 4;
+    buf += descriptors_loop_len + 4;
+
+    while (len > 6) {
+        uint16_t transport_stream_id = (buf[0] << 8) | buf[1];
+        uint16_t original_network_id = (buf[2] << 8) | buf[3];
+        struct transponder *t;
+
+        descriptors_loop_len = ((buf[4] & 0x0f) << 8) | buf[5];
+        if (len < descriptors_loop_len + 6)
+            break;
+
+        if ((t = find_transponder_by_ts(original_network_id, transport_stream_id)) == NULL)
+            verbose("        BAT: unknown transport stream (%u:xxxx:%u)\n", original_network_id, transport_stream_id);
+        else {
+            descriptor_iter_init(&it, buf + 6, descriptors_loop_len, NULL);
+            while (descriptor_next(&it, &d)) {
+                int i;
+
+                switch (d.tag) {
+                case service_list_descriptor:
+                    for (i = 0; i + 3 <= d.length; i += 3) {
+                        uint16_t service_id = (d.buf[2 + i] << 8) | d.buf[3 + i];
+                        struct service *s = find_service(t, service_id);
+
+                        if (s == NULL)
+                            s = alloc_service(t, service_id);
+                        if (s->type == 0) // the service descriptor's one is preferred.
+                            s->type = d.buf[4 + i];
+                    }
+                    break;
+                case logical_channel_descriptor:
+                    parse_logical_channel_descriptor(d.buf, t);
+                    break;
+                default:;
+                }
+            }
+        }
+        len -= descriptors_loop_len + 6;
+        buf += descriptors_loop_len + 6;
+    }
+}
+
+/* M7 FastScan network table (FNT): NIT syntax, network_id is the operator's
+ * FastScan network. Only the transport stream loop is used: satellite delivery
+ * system and logical channel descriptors.
+ */
+static void
+parse_fnt(unsigned char const *buf, uint16_t section_length, uint16_t network_id)
+{
+    int len = section_length;
+    int descriptors_loop_len = ((buf[0] & 0x0f) << 8) | buf[1];
+    char buffer[128];
+
+    hexdump(__FUNCTION__, buf, section_length);
+
+    if (len < descriptors_loop_len + 4)
+        return;
+    len -= descriptors_loop_len + 4;
+    buf += descriptors_loop_len + 4;
+
+    while (len > 6) {
+        struct transponder *t, tn;
+        struct descriptor_iter it;
+        struct descriptor d;
+        uint16_t transport_stream_id = (buf[0] << 8) | buf[1];
+        uint16_t original_network_id = (buf[2] << 8) | buf[3];
+
+        descriptors_loop_len = ((buf[4] & 0x0f) << 8) | buf[5];
+        if (len < descriptors_loop_len + 6)
+            break;
+
+        memset(&tn, 0, sizeof(tn));
+        tn.type = current_tp->type;
+        tn.network_PID = PID_NIT_ST;
+        tn.network_id = network_id;
+        tn.original_network_id = original_network_id;
+        tn.transport_stream_id = transport_stream_id;
+        tn.services = &tn._services;
+        NewList(tn.services, "tn_services");
+        tn.cells = &tn._cells;
+        NewList(tn.cells, "tn_cells");
+
+        parse_descriptors(TABLE_FASTSCAN_FNT, buf + 6, descriptors_loop_len, &tn, flags.scantype);
+        tn.source |= TABLE_FASTSCAN_FNT << 8;
+
+        if ((t = find_transponder(original_network_id, network_id, transport_stream_id)) == NULL) {
+            if ((t = find_transponder_by_freq(&tn)) == NULL) {
+                if (!tn.frequency || (tn.type != flags.scantype)) {
+                    len -= descriptors_loop_len + 6;
+                    buf += descriptors_loop_len + 6;
+                    continue;
+                }
+                t = alloc_transponder(tn.frequency, tn.delsys, tn.polarization);
+            }
+            copy_transponder(t, &tn);
+            tp_index_update(t);
+            print_transponder(buffer, t);
+            verbose("        FNT: (%u:%u:%u) %s\n", original_network_id, network_id, transport_stream_id, buffer);
+        }
+
+        descriptor_iter_init(&it, buf + 6, descriptors_loop_len, NULL);
+        while (descriptor_next(&it, &d)) {
+            if (d.tag == logical_channel_descriptor)
+                parse_logical_channel_descriptor(d.buf, t);
+        }
+
+        len -= descriptors_loop_len + 6;
+        buf += descriptors_loop_len + 6;
+    }
+}
+
+/* M7 FastScan services table (FST): one entry per service with the default pids, i.e.
+ * all we usually get from PAT, PMT and SDT of the service's transponder.
+ */
+static void
+parse_fst(unsigned char const *buf, uint16_t section_length, uint16_t network_id)
+{
+    int len = section_length;
+
+    hexdump(__FUNCTION__, buf, section_length);
+
+    while (len >= 18) {
+        uint16_t original_network_id = (buf[0] << 8) | buf[1];
+        uint16_t transport_stream_id = (buf[2] << 8) | buf[3];
+        uint16_t service_id = (buf[4] << 8) | buf[5];
+        uint16_t video_pid = ((buf[6] & 0x1f) << 8) | buf[7];
+        uint16_t audio_pid = ((buf[8] & 0x1f) << 8) | buf[9];
+        uint16_t video_ecm_pid = ((buf[10] & 0x1f) << 8) | buf[11];
+        uint16_t audio_ecm_pid = ((buf[12] & 0x1f) << 8) | buf[13];
+        uint16_t pcr_pid = ((buf[14] & 0x1f) << 8) | buf[15];
+        int descriptors_loop_len = ((buf[16] & 0x0f) << 8) | buf[17];
+        struct transponder *t;
+        struct service *s;
+
+        if (len < descriptors_loop_len + 18)
+            break;
+
+        t = find_transponder(original_network_id, network_id, transport_stream_id);
+        if (t == NULL) {
+            verbose(
+                "        FST: service %u on unknown transponder (%u:%u:%u)\n",
+                service_id,
+                original_network_id,
+                network_id,
+                transport_stream_id);
+        } else {
+            if ((s = find_service(t, service_id)) == NULL)
+                s = alloc_service(t, service_id);
+            s->transport_stream_id = transport_stream_id;
+            s->pcr_pid = pcr_pid;
+            s->scrambled = (video_ecm_pid && (video_ecm_pid != 0x1FFF)) || (audio_ecm_pid && (audio_ecm_pid != 0x1FFF));
+            // FST service descriptors are the ones of the SDT.
+            parse_descriptors(TABLE_SDT_OTH, buf + 18, descriptors_loop_len, s, flags.scantype);
+            if (video_pid && (video_pid != 0x1FFF)) {
+                s->video_pid = video_pid;
+                switch (s->type) { // EN 300 468 Table 87, service_type
+                case 0x16 ... 0x19: // advanced codec digital television
+                    s->video_stream_type = iso_iec_14496_10_AVC_video_stream;
+                    break;
+                case 0x1F: // HEVC digital television
+                    s->video_stream_type = iso_iec_23008_2_H265_video_hevc_stream;
+                    break;
+                default:
+                    s->video_stream_type = iso_iec_13818_1_11172_2_video_stream;
+                }
+            }
+            if (audio_pid && (audio_pid != 0x1FFF) && (s->audio_num == 0)) {
+                s->audio_pid[0] = audio_pid;
+                s->audio_stream_type[0] = iso_iec_13818_3_audio_stream;
+                s->audio_num = 1;
+            }
+        }
+        len -= descriptors_loop_len + 18;
+        buf += descriptors_loop_len + 18;
+    }
+}
+
+em_static void
+parse_psip_descriptors(struct service *s, unsigned char const *buf, int len)
+{
+    struct descriptor_iter it;
+    struct descriptor d;
+
+    hexdump(__FUNCTION__, buf, len);
+
+    descriptor_iter_init(&it, buf, len, NULL);
+    while (descriptor_next(&it, &d)) {
+        switch (d.tag) {
+        case atsc_service_location_descriptor:
+            parse_atsc_service_location_descriptor(s, d.buf);
+            break;
+        case atsc_extended_channel_name_descriptor:
+            parse_atsc_extended_channel_name_descriptor(s, d.buf);
+            break;
+        default:
+            warning("unhandled psip descriptor: %02x\n", d.tag);
+            break;
         }
-        b += 2 + descriptor_length;
-        len -= 2 + descriptor_length;
     }
 }
 
@@ -1771,6 +2139,125 @@ set_bit(uint8_t *bitfield, int bit)
     bitfield[bit / 8] |= 1 << (bit % 8);
 }
 
+/* CLOCK_MONOTONIC in msec, same clock as timer_fd. */
+static int64_t
+filter_clock(void)
+{
+    struct timespec t;
+
+    backend->clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+#define FILTER_MARGIN 250 // msec, added to all filter timeouts.
+
+/* repetition interval of each table_id, as observed on the current transponder:
+ * the largest time between two arrivals of the same section, see observe_section().
+ */
+static __thread struct {
+    uint32_t cycle; // msec, 0 == unknown.
+} table_cycles[256];
+
+/* first arrival of each section of one table (table_id, table_id_ext), as seen by one filter run.
+ * Arrivals of an earlier run are not used, the time between two filters is no repetition.
+ */
+struct table_arrivals {
+    /*----------------------------*/
+    void *prev;
+    void *next;
+    pList list;
+    /*----------------------------*/
+    uint8_t table_id;
+    uint16_t table_id_ext;
+    unsigned run; // see section_buf.run
+    int64_t first[256]; // msec by section_number, 0 == not seen yet.
+};
+
+static __thread cList _table_arrivals, *table_arrivals = NULL;
+static __thread unsigned filter_runs;
+
+static char const *rate_cache_file = NULL; // --rate-cache, see rate-cache.h
+static char const *capture_file = NULL; // --capture, see em_capture()
+static char const **ts_files = NULL; // --ts, see em_add_tsfile()
+static unsigned n_ts_files = 0;
+static int fastscan_pid = -1; // --fastscan
+static bool quick = false; // --quick
+
+/* known repetition interval of table_id in msec, 0 == unknown: as seen on this transponder,
+ * on an earlier transponder of the same network or, with --rate-cache, in an earlier scan.
+ */
+static uint32_t
+table_interval(int table_id)
+{
+    if ((table_id < 0) || (table_id > 0xFF))
+        return 0;
+    if (table_cycles[table_id].cycle)
+        return table_cycles[table_id].cycle;
+    if (current_tp)
+        return rate_cache_get(current_tp->original_network_id, current_tp->network_id, table_id);
+    return 0;
+}
+
+/* forget all repetition intervals and arrivals, i.e. after tuning. */
+static void
+reset_table_cycles(void)
+{
+    memset(table_cycles, 0, sizeof(table_cycles));
+    if (table_arrivals == NULL) {
+        table_arrivals = &_table_arrivals;
+        NewList(table_arrivals, "table_arrivals");
+    }
+    ClearList(table_arrivals);
+}
+
+/* a section of s arrived: once any section of a table comes back to the same filter run,
+ * the time since its first arrival is the table's repetition interval.
+ */
+static void
+observe_section(struct section_buf *s, uint8_t table_id, uint16_t table_id_ext, uint8_t section_number)
+{
+    struct table_arrivals *a;
+    int64_t now = filter_clock();
+
+    if (table_arrivals == NULL)
+        reset_table_cycles();
+    for (a = table_arrivals->first; a; a = a->next) {
+        if ((a->table_id == table_id) && (a->table_id_ext == table_id_ext))
+            break;
+    }
+    if (a == NULL) {
+        a = calloc(1, sizeof(struct table_arrivals));
+        a->table_id = table_id;
+        a->table_id_ext = table_id_ext;
+        a->run = s->run;
+        AddItem(table_arrivals, a);
+    }
+
+    if (a->first[section_number] && (now - a->first[section_number] < 10))
+        return; // same section passed to more than one filter.
+    if (a->run != s->run) {
+        memset(a->first, 0, sizeof(a->first));
+        a->run = s->run;
+    }
+    if (a->first[section_number]) {
+        uint32_t cycle = now - a->first[section_number];
+
+        verbosedebug("table_id 0x%02x table_id_ext %u: repetition interval %u msec\n", table_id, table_id_ext, cycle);
+        if (cycle > table_cycles[table_id].cycle)
+            table_cycles[table_id].cycle = cycle;
+    }
+    a->first[section_number] = now;
+}
+
+/* a complete table is read on until its repetition interval is known, i.e. once per network. */
+static bool
+measuring(struct section_buf const *s)
+{
+    if (s->segmented)
+        return false;
+    return table_interval(s->table_id) == 0;
+}
+
 /*   returns 0 when more sections are expected
  *           1 when all sections are read on this pid
  *          -1 on invalid table id
@@ -1778,6 +2265,7 @@ set_bit(uint8_t *bitfield, int bit)
 static int
 parse_section(struct section_buf *s)
 {
+    struct section_buf *head = s;
     unsigned char const *buf = s->buf;
     uint8_t table_id;
     // uint8_t  section_syntax_indicator;
@@ -1801,14 +2289,15 @@ parse_section(struct section_buf *s)
         int verbosity = 5;
         int slow_rep_rate = 30 + repetition_rate(flags.scantype, s->table_id);
         hexdump(__FUNCTION__, &buf[0], section_length + 14);
-        if (s->timeout < slow_rep_rate) {
+        if (s->timeout < slow_rep_rate * 1000U) {
             info(
                 "increasing filter timeout to %d secs (pid:%d table_id:%d table_id_ext:%d).\n",
                 slow_rep_rate,
                 s->pid,
                 s->table_id,
                 s->table_id_ext);
-            s->timeout = slow_rep_rate;
+            s->timeout = slow_rep_rate * 1000U;
+            s->deadline = s->start_time + s->timeout;
         }
 
         pList list = s->garbage;
@@ -1818,7 +2307,7 @@ parse_section(struct section_buf *s)
             NewList(list, "s->garbage");
             s->garbage = list;
         }
-        memcpy(&p[sizeof(cItem) - 1], buf, SECTION_BUF_SIZE);
+        memcpy(&p[sizeof(cItem)], buf, SECTION_BUF_SIZE);
         AddItem(s->garbage, p);
         // if ((s->garbage)->count > 3)
         //    return fuzzy_section(s);
@@ -1834,6 +2323,25 @@ parse_section(struct section_buf *s)
     // pcr_pid = ((buf[8] & 0x1f) << 8) | buf[9];
     // program_info_length = ((buf[10] & 0x0f) << 8) | buf[11];
 
+    observe_section(head, table_id, table_id_ext, section_number);
+
+    if (s->segmented) {
+        /* NIT-other is the same on all transponders of a network. Once a network was
+         * read completely, stop as soon as a full cycle brings nothing new.
+         */
+        uint32_t crc = (buf[section_length + 8] << 24) | (buf[section_length + 9] << 16) |
+                       (buf[section_length + 10] << 8) | buf[section_length + 11];
+
+        if (!si_cache_section(buf, section_length + 12))
+            s->quiet_crc = 0;
+        else if (s->quiet_crc == 0)
+            s->quiet_crc = crc;
+        else if ((s->quiet_crc == crc) && current_tp->network_id && si_cache_complete(table_id, current_tp->network_id)) {
+            verbose("table_id 0x%02x: no new sections, network_id %u already known.\n", table_id, current_tp->network_id);
+            s->known_cycle = 1;
+        }
+    }
+
     if (s->segmented && s->table_id_ext != -1 && s->table_id_ext != table_id_ext) {
         /* find or allocate actual section_buf matching table_id_ext */
         while (s->next_seg) {
@@ -1876,6 +2384,7 @@ parse_section(struct section_buf *s)
 
     if (!get_bit(s->section_done, section_number)) {
         set_bit(s->section_done, section_number);
+        em_record(EM_REC_SECTION, head->pid, buf - 8, section_length + 12);
 
         verbosedebug(
             "pid %d (0x%02x), tid %d (0x%02x), table_id_ext %d (0x%04x), "
@@ -1902,6 +2411,23 @@ parse_section(struct section_buf *s)
         case TABLE_NIT_ACT:
         case TABLE_NIT_OTH:
             verbose("NIT(%s TS, network_id %d (0x%04x) )\n", table_id == 0x40 ? "actual" : "other", table_id_ext, table_id_ext);
+            if (table_id == TABLE_NIT_OTH) {
+                /* NIT-other is the same on all transponders of a network and changes the
+                 * transponder lists only, which is done after the first time.
+                 */
+                uint32_t source;
+
+                if (si_cache_parsed(buf - 8, section_length + 12, &source)) {
+                    verbose("        (already parsed)\n");
+                    if (source)
+                        current_tp->source = source;
+                    break;
+                }
+                parse_nit(buf, section_length, table_id, table_id_ext);
+                if (nit_other_is_context_free(buf, section_length, &source))
+                    si_cache_set_parsed(buf - 8, section_length + 12, source ? current_tp->source : 0);
+                break;
+            }
             parse_nit(buf, section_length, table_id, table_id_ext);
             break;
         case TABLE_SDT_ACT:
@@ -1911,7 +2437,22 @@ parse_section(struct section_buf *s)
                 table_id == 0x42 ? "actual" : "other",
                 table_id_ext,
                 table_id_ext);
-            parse_sdt(buf, section_length, table_id_ext);
+            if (table_id == TABLE_SDT_OTH)
+                parse_sdt_other(buf, section_length, table_id_ext);
+            else
+                parse_sdt(buf, section_length, table_id_ext);
+            break;
+        case TABLE_BAT:
+            verbose("BAT, bouquet_id %d (0x%04x)\n", table_id_ext, table_id_ext);
+            parse_bat(buf, section_length, table_id_ext);
+            break;
+        case TABLE_FASTSCAN_FNT:
+            verbose("FastScan FNT, network_id %d (0x%04x)\n", table_id_ext, table_id_ext);
+            parse_fnt(buf, section_length, table_id_ext);
+            break;
+        case TABLE_FASTSCAN_FST:
+            verbose("FastScan FST, network_id %d (0x%04x)\n", table_id_ext, table_id_ext);
+            parse_fst(buf, section_length, table_id_ext);
             break;
         case TABLE_VCT_TERR:
         case TABLE_VCT_CABLE:
@@ -1925,38 +2466,42 @@ parse_section(struct section_buf *s)
             if (get_bit(s->section_done, i) == 0)
                 break;
 
-        if (i > last_section_number)
+        if (i > last_section_number) {
             s->sectionfilter_done = 1;
+            if (table_id == TABLE_SDT_OTH) {
+                struct transponder *t = find_transponder_by_ts((buf[0] << 8) | buf[1], table_id_ext);
+
+                if (t && (t != current_tp))
+                    t->sdt_other_complete = true;
+            }
+        }
+    } else if (!s->segmented && !s->sectionfilter_done && (s->garbage == NULL) && table_cycles[table_id].cycle) {
+        /* a full repetition seen, but still sections missing: they should show up
+         * within the next cycle. With CRC errors, keep the longer timeout.
+         */
+        int64_t deadline = filter_clock() + table_cycles[table_id].cycle + FILTER_MARGIN;
+        if (deadline < s->deadline)
+            s->deadline = deadline;
     }
 
     if (s->segmented) {
-        /* always wait for timeout; this is because we don't now how
+        /* wait for timeout; this is because we don't now how
          * many segments there are
          */
-        return 0;
-    } else if (s->sectionfilter_done)
+        return head->known_cycle;
+    } else if (s->sectionfilter_done && !measuring(s))
         return 1;
 
     return 0;
 }
 
+/* checks and parses one complete section of count bytes in s->buf.
+ * returns like read_sections().
+ */
 static int
-read_sections(struct section_buf *s)
+check_section(struct section_buf *s, int count)
 {
-    int section_length, count;
-
-    if (s->sectionfilter_done && !s->segmented)
-        return 1;
-
-    /* the section filter API guarantess that we get one full section
-     * per read(), provided that the buffer is large enough (it is)
-     */
-    if (((count = read(s->fd, s->buf, sizeof(s->buf))) < 0) && errno == EOVERFLOW)
-        count = read(s->fd, s->buf, sizeof(s->buf));
-    if (count < 0) {
-        errorn("read error: (count < 0)");
-        return -1;
-    }
+    int section_length;
 
     if (count < 4)
         return -1;
@@ -1972,15 +2517,56 @@ read_sections(struct section_buf *s)
     return 0;
 }
 
-cList _running_filters, *running_filters = &_running_filters;
-cList _waiting_filters, *waiting_filters = &_waiting_filters;
-static int n_running;
+static int
+read_sections(struct section_buf *s)
+{
+    int count;
+
+    if (s->sectionfilter_done && !s->segmented && !measuring(s))
+        return 1;
+
+    /* the section filter API guarantess that we get one full section
+     * per read(), provided that the buffer is large enough (it is)
+     */
+    if (((count = backend->read(s->fd, s->buf, sizeof(s->buf))) < 0) && errno == EOVERFLOW)
+        count = backend->read(s->fd, s->buf, sizeof(s->buf));
+    if (count < 0) {
+        errorn("read error: (count < 0)");
+        return -1;
+    }
+
+    return check_section(s, count);
+}
+
+static __thread cList _running_filters, _waiting_filters;
+static __thread pList running_filters, waiting_filters; // see init_filter_lists().
+static __thread int n_running;
 // see http://www.linuxtv.org/pipermail/linux-dvb/2005-October/005577.html:
 // #define MAX_RUNNING 32
 #define MAX_RUNNING 27
 
-static struct pollfd poll_fds[MAX_RUNNING];
-static struct section_buf *poll_section_bufs[MAX_RUNNING];
+static __thread int epoll_fd = -1; // running filters and timer_fd, see read_filters().
+static __thread int timer_fd = -1; // expires at the earliest deadline of all running filters.
+
+/* stopped, but still open demux fds. Opening and closing a demux for each and every
+ * filter is slow on some (USB) devices, so section filters are re-armed instead.
+ */
+static __thread int dmx_pool[MAX_RUNNING];
+static __thread int dmx_pool_count;
+#define DMX_BUFFER_SIZE (4 * SECTION_BUF_SIZE) // kernel buffer for each section filter.
+
+static bool userspace_demux = false; // all filters share one raw TS filter, see ts-demux.h
+static __thread struct ts_demux *ts_demux = NULL;
+static __thread int ts_demux_done; // a filter completed while in ts_demux_read().
+
+static void
+init_filter_lists(void)
+{
+    running_filters = &_running_filters;
+    waiting_filters = &_waiting_filters;
+    NewList(running_filters, "running_filters");
+    NewList(waiting_filters, "waiting_filters");
+}
 
 static void
 setup_filter(
@@ -2003,11 +2589,13 @@ setup_filter(
 
     s->run_once = run_once;
     s->segmented = segmented;
-    s->timeout = 1; // add 1sec for safety..
+    s->timeout = 1000U * repetition_rate(flags.scantype, table_id);
     if (flags.filter_timeout > 0)
-        s->timeout += 5 * repetition_rate(flags.scantype, table_id);
-    else
-        s->timeout += repetition_rate(flags.scantype, table_id);
+        s->timeout *= 5;
+    else if (table_interval(table_id) && (2 * table_interval(table_id) < s->timeout))
+        // seen on this transponder or in this network before: wait at most two repetitions.
+        s->timeout = 2 * table_interval(table_id);
+    s->timeout += FILTER_MARGIN;
 
     s->table_id_ext = table_id_ext;
     s->section_version_number = -1;
@@ -2017,41 +2605,126 @@ setup_filter(
 }
 
 static void
-update_poll_fds(void)
+init_filter_events(void)
+{
+    struct epoll_event ev;
+
+    if (epoll_fd >= 0)
+        return;
+    if ((epoll_fd = backend->epoll_create1(EPOLL_CLOEXEC)) < 0)
+        fatal("epoll_create1 failed: %d %s\n", errno, strerror(errno));
+    if ((timer_fd = backend->timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+        fatal("timerfd_create failed: %d %s\n", errno, strerror(errno));
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // NULL == timer_fd, otherwise the section_buf.
+    if (backend->epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) < 0)
+        fatal("epoll_ctl failed: %d %s\n", errno, strerror(errno));
+
+    if (ts_demux != NULL) {
+        ev.data.ptr = ts_demux;
+        if (backend->epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ts_demux->fd, &ev) < 0)
+            fatal("epoll_ctl failed: %d %s\n", errno, strerror(errno));
+    }
+}
+
+/* (re-)arm timer_fd to the earliest deadline of all running filters, or disarm it. */
+static void
+update_filter_timer(void)
 {
+    struct itimerspec its;
     struct section_buf *s;
-    int i;
+    int64_t deadline = 0;
 
-    memset(poll_section_bufs, 0, sizeof(poll_section_bufs));
-    for (i = 0; i < MAX_RUNNING; i++)
-        poll_fds[i].fd = -1;
-    i = 0;
     for (s = running_filters->first; s; s = s->next) {
-        if (i >= MAX_RUNNING)
-            fatal("too many poll_fds\n");
-        if (s->fd == -1)
-            fatal("s->fd == -1 on running_filters\n");
-        verbosedebug("poll fd %d\n", s->fd);
-        poll_fds[i].fd = s->fd;
-        poll_fds[i].events = POLLIN;
-        poll_fds[i].revents = 0;
-        poll_section_bufs[i] = s;
-        i++;
-    }
-    if (i != n_running)
-        fatal("n_running is hosed\n");
+        if ((deadline == 0) || (s->deadline < deadline))
+            deadline = s->deadline;
+    }
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = deadline / 1000;
+    its.it_value.tv_nsec = (deadline % 1000) * 1000000;
+    if (backend->timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+        errorn("timerfd_settime");
+}
+
+static int
+get_demux_fd(char const *dmx_devname)
+{
+    int fd;
+
+    if (dmx_pool_count > 0)
+        return dmx_pool[--dmx_pool_count];
+
+    if ((fd = backend->open(dmx_devname, O_RDWR)) < 0)
+        return -1;
+    if (backend->ioctl(fd, DMX_SET_BUFFER_SIZE, DMX_BUFFER_SIZE) < 0)
+        verbose("%s: DMX_SET_BUFFER_SIZE failed: %d %s\n", __FUNCTION__, errno, strerror(errno));
+    return fd;
+}
+
+/* returns a stopped demux fd to the pool. The next DMX_SET_FILTER with DMX_IMMEDIATE_START
+ * flushes any data left in its buffer.
+ */
+static void
+put_demux_fd(int fd)
+{
+    backend->ioctl(fd, DMX_STOP, NULL);
+    if (dmx_pool_count < MAX_RUNNING)
+        dmx_pool[dmx_pool_count++] = fd;
+    else
+        backend->close(fd);
+}
+
+/* closes the demux fds, the userspace demux and the filter events of this thread, once its scan is done. */
+static void
+close_filter_devices(void)
+{
+    while (dmx_pool_count > 0)
+        backend->close(dmx_pool[--dmx_pool_count]);
+    ts_demux_close(ts_demux);
+    ts_demux = NULL;
+    if (timer_fd >= 0)
+        backend->close(timer_fd);
+    if (epoll_fd >= 0)
+        backend->close(epoll_fd);
+    timer_fd = epoll_fd = -1;
+}
+
+static void
+add_running_filter(struct section_buf *s)
+{
+    s->sectionfilter_done = 0;
+    s->run = ++filter_runs;
+    s->start_time = filter_clock();
+    s->deadline = s->start_time + s->timeout;
+
+    AddItem(running_filters, s);
+
+    n_running++;
+    update_filter_timer();
 }
 
 static int
 start_filter(struct section_buf *s)
 {
     struct dmx_sct_filter_params f;
+    struct epoll_event ev;
+
+    if (ts_demux != NULL) {
+        if (ts_demux_add_pid(ts_demux, s->pid) < 0)
+            return -1;
+        verbosedebug("%s pid %d (0x%04x) table_id 0x%02x (userspace demux)\n", __FUNCTION__, s->pid, s->pid, s->table_id);
+        init_filter_events();
+        add_running_filter(s);
+        return 0;
+    }
 
     if (n_running >= MAX_RUNNING) {
         verbose("%s: too much filters. skip for now\n", __FUNCTION__);
         goto err0;
     }
-    if ((s->fd = open(s->dmx_devname, O_RDWR)) < 0) {
+    if ((s->fd = get_demux_fd(s->dmx_devname)) < 0) {
         warning("%s: could not open demux.\n", __FUNCTION__);
         goto err0;
     }
@@ -2069,24 +2742,31 @@ start_filter(struct section_buf *s)
     f.timeout = 0;
     f.flags = DMX_IMMEDIATE_START;
 
-    if (ioctl(s->fd, DMX_SET_FILTER, &f) == -1) {
+    if (backend->ioctl(s->fd, DMX_SET_FILTER, &f) == -1) {
         errorn("ioctl DMX_SET_FILTER failed");
         goto err1;
     }
 
-    s->sectionfilter_done = 0;
-    time(&s->start_time);
-
-    AddItem(running_filters, s);
-
-    n_running++;
-    update_poll_fds();
+    init_filter_events();
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = s;
+    if (backend->epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s->fd, &ev) < 0) {
+        errorn("epoll_ctl EPOLL_CTL_ADD failed");
+        goto err2;
+    }
 
+    add_running_filter(s);
     return 0;
 
+err2:
+    put_demux_fd(s->fd);
+    s->fd = -1;
+    return -1;
 err1:
-    ioctl(s->fd, DMX_STOP);
-    close(s->fd);
+    backend->ioctl(s->fd, DMX_STOP, NULL);
+    backend->close(s->fd);
+    s->fd = -1;
 err0:
     return -1;
 }
@@ -2096,15 +2776,19 @@ stop_filter(struct section_buf *s)
 {
     verbosedebug("%s: pid %d (0x%04x)\n", __FUNCTION__, s->pid, s->pid);
 
-    ioctl(s->fd, DMX_STOP);
-    close(s->fd);
+    if (ts_demux != NULL)
+        ts_demux_remove_pid(ts_demux, s->pid);
+    else {
+        backend->epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+        put_demux_fd(s->fd);
+    }
 
     s->fd = -1;
     UnlinkItem(running_filters, s, false);
-    s->running_time += time(NULL) - s->start_time;
+    s->running_time += filter_clock() - s->start_time;
 
     n_running--;
-    update_poll_fds();
+    update_filter_timer();
     if (s->garbage) {
         ClearList(s->garbage);
         free(s->garbage);
@@ -2138,110 +2822,172 @@ remove_filter(struct section_buf *s)
         UnlinkItem(waiting_filters, s, false);
         if (start_filter(s)) {
             // any non-zero is error -> put again to list.
-            InsertItem(waiting_filters, s, 0);
+            InsertItemBefore(waiting_filters, s, waiting_filters->first);
             break;
         }
     }
 }
 
+/* userspace_demux: pass a section from ts_demux_read() to all matching running filters. */
+static void
+ts_demux_section(uint16_t pid, unsigned char const *section, int length)
+{
+    struct section_buf *s, *next;
+
+    for (s = running_filters->first; s; s = next) {
+        next = s->next;
+        if (s->pid != pid)
+            continue;
+        // same as the kernel section filter in start_filter().
+        if ((s->table_id < 0x100) && (s->table_id > 0) && (section[0] != s->table_id))
+            continue;
+        if (s->sectionfilter_done && !s->segmented && !measuring(s))
+            continue;
+
+        memcpy(s->buf, section, length);
+        if ((check_section(s, length) == 1) && s->run_once) {
+            verbosedebug("filter success: pid 0x%04x\n", s->pid);
+            remove_filter(s);
+            ts_demux_done = 1;
+        }
+    }
+}
+
 /* return value:
  * non-zero on success.
  * zero on timeout.
+ *
+ * Sleeps in epoll_wait() until either a running filter has data or
+ * timer_fd signals that the earliest filter deadline is reached.
  */
 static int
 read_filters(void)
 {
-    struct section_buf *s;
+    struct epoll_event events[MAX_RUNNING + 1];
+    struct section_buf *s, *next;
     int i, n, done = 0;
+    int64_t now;
+
+    if (n_running == 0) {
+        unlocked(backend->usleep(25000));
+        return 0;
+    }
 
-    n = poll(poll_fds, n_running, 25);
-    if (n == -1)
-        errorn("poll");
+    unlocked(n = backend->epoll_wait(epoll_fd, events, MAX_RUNNING + 1, -1));
+    if (n == -1) {
+        if (errno != EINTR)
+            errorn("epoll_wait");
+        n = 0;
+    }
 
-    for (i = 0; i < n_running; i++) {
-        s = poll_section_bufs[i];
-        if (!s)
-            fatal("poll_section_bufs[%d] is NULL\n", i);
-        if (poll_fds[i].revents)
-            done = read_sections(s) == 1;
-        else
-            done = 0; /* timeout */
-        if (done || time(NULL) > s->start_time + s->timeout) {
-            if (s->run_once) {
-                if (done)
-                    verbosedebug("filter success: pid 0x%04x\n", s->pid);
-                else {
-                    char const *intro = "        Info: no data from ";
-                    // timeout waiting for data.
-                    switch (s->table_id) {
-                    case TABLE_PAT:
-                        info("%sPAT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_CAT:
-                        info("%sCAT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_PMT:
-                        info("%sPMT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_TSDT:
-                        info("%sTSDT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_NIT_ACT:
-                        info("%sNIT(actual )after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_NIT_OTH:
-                        verbose("%sNIT(other) after %lld seconds\n", intro, (long long)s->timeout);
-                        break; // not always available.
-                    case TABLE_SDT_ACT:
-                        info("%sSDT(actual) after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_SDT_OTH:
-                        info("%sSDT(other) after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_BAT:
-                        info("%sBAT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_EIT_ACT:
-                        info("%sEIT(actual) after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_EIT_OTH:
-                        info("%sEIT(other) after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_TDT:
-                        info("%sTDT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_RST:
-                        info("%sRST after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_TOT:
-                        info("%sTOT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_AIT:
-                        info("%sAIT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_CST:
-                        info("%sCST after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_RCT:
-                        info("%sRCT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_CIT:
-                        info("%sCIT after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_VCT_TERR:
-                        info("%sVCT(terr) after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    case TABLE_VCT_CABLE:
-                        info("%sVCT(cable) after %lld seconds\n", intro, (long long)s->timeout);
-                        break;
-                    default:
-                        info("%spid %u after %lld seconds\n", intro, s->pid, (long long)s->timeout);
-                    }
-                }
+    for (i = 0; i < n; i++) {
+        s = events[i].data.ptr;
+        if (s == NULL) {
+            uint64_t expirations;
+            if ((backend->read(timer_fd, &expirations, sizeof(expirations)) < 0) && (errno != EAGAIN))
+                errorn("read timer_fd");
+            continue;
+        }
+        if (events[i].data.ptr == ts_demux) {
+            ts_demux_done = 0;
+            ts_demux_read(ts_demux, ts_demux_section);
+            done |= ts_demux_done;
+            continue;
+        }
+        if ((read_sections(s) == 1) && s->run_once) {
+            verbosedebug("filter success: pid 0x%04x\n", s->pid);
+            remove_filter(s);
+            done = 1;
+        }
+    }
+
+    now = filter_clock();
+    for (s = running_filters->first; s; s = next) {
+        next = s->next;
+        if (s->run_once && s->sectionfilter_done && !s->segmented) {
+            // complete, kept running until the table was seen repeating.
+            if (!measuring(s) || (now >= s->deadline)) {
+                verbosedebug("filter success: pid 0x%04x\n", s->pid);
                 remove_filter(s);
+                done = 1;
+            }
+            continue;
+        }
+        if (s->run_once && (now >= s->deadline)) {
+            char const *intro = "        Info: no data from ";
+            // timeout waiting for data.
+            switch (s->table_id) {
+            case TABLE_PAT:
+                info("%sPAT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_CAT:
+                info("%sCAT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_PMT:
+                info("%sPMT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_TSDT:
+                info("%sTSDT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_NIT_ACT:
+                info("%sNIT(actual )after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_NIT_OTH:
+                verbose("%sNIT(other) after %u msec\n", intro, s->timeout);
+                // with CRC errors, sections may be missing: read the full cycle again on the next transponder.
+                if (s->segmented && (s->garbage == NULL) && current_tp->network_id)
+                    si_cache_set_complete(s->table_id, current_tp->network_id);
+                break; // not always available.
+            case TABLE_SDT_ACT:
+                info("%sSDT(actual) after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_SDT_OTH:
+            case TABLE_BAT:
+                verbose("%s%s after %u msec\n", intro, s->table_id == TABLE_BAT ? "BAT" : "SDT(other)", s->timeout);
+                if (s->segmented && (s->garbage == NULL) && current_tp->network_id)
+                    si_cache_set_complete(s->table_id, current_tp->network_id);
+                break; // not always available.
+            case TABLE_EIT_ACT:
+                info("%sEIT(actual) after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_EIT_OTH:
+                info("%sEIT(other) after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_TDT:
+                info("%sTDT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_RST:
+                info("%sRST after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_TOT:
+                info("%sTOT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_AIT:
+                info("%sAIT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_CST:
+                info("%sCST after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_RCT:
+                info("%sRCT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_CIT:
+                info("%sCIT after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_VCT_TERR:
+                info("%sVCT(terr) after %u msec\n", intro, s->timeout);
+                break;
+            case TABLE_VCT_CABLE:
+                info("%sVCT(cable) after %u msec\n", intro, s->timeout);
+                break;
+            default:
+                info("%spid %u after %u msec\n", intro, s->pid, s->timeout);
             }
+            remove_filter(s);
         }
     }
+    // timer_fd is one-shot: re-arm for the remaining filters.
+    update_filter_timer();
     return done;
 }
 
@@ -2290,6 +3036,7 @@ static void
 copy_fe_params(struct transponder *dest, struct transponder *source)
 {
     memcpy(&dest->frequency, &source->frequency, (void *)&source->private_from_here - (void *)&source->frequency);
+    tp_index_update(dest);
 
     // NOTE: pointer calc in memcpy is 36 bytes actually.
 }
@@ -2317,7 +3064,7 @@ set_frontend(int frontend_fd, struct transponder *t)
             if (setup_scr(frontend_fd, t, &this_lnb, &scr_config) != 0)
                 return -2;
             // repeat diseqc sequence after 100msec, because it may fail and we cannot check here.
-            usleep(100000);
+            backend->usleep(100000);
             if (setup_scr(frontend_fd, t, &this_lnb, &scr_config))
                 return -2;
             intermediate_freq = (scr_config.user_frequency + scr_config.offset) * 1000UL; // tune dvb card to users freq. NOTE:
@@ -2338,10 +3085,9 @@ set_frontend(int frontend_fd, struct transponder *t)
                             uncommitted_switch) != 0)
                         return -2; // error
 
-                    usleep(50000);
-                } else {
-                    em_lnb(switch_to_high_band, this_lnb.high_val, this_lnb.low_val);
+                    unlocked(backend->usleep(50000));
                 }
+                em_lnb(switch_to_high_band, this_lnb.high_val, this_lnb.low_val);
 
                 if (switch_to_high_band)
                     intermediate_freq = abs(t->frequency - this_lnb.high_val);
@@ -2475,10 +3221,11 @@ set_frontend(int frontend_fd, struct transponder *t)
         }
         set_cmd_sequence(DTV_TUNE, DTV_UNDEFINED);
         EMUL(em_setproperty, &cmdseq)
-        if (ioctl(frontend_fd, FE_SET_PROPERTY, &cmdseq) < 0) {
+        if (backend->ioctl(frontend_fd, FE_SET_PROPERTY, &cmdseq) < 0) {
             errorn("Setting frontend parameters failed\n");
             return -1;
         }
+        em_record(EM_REC_SET_PROPERTY, 0, cmdseq.props, cmdseq.num * sizeof(struct dtv_property));
         break;
     default:
         fatal("unsupported DVB API Version %d.%d\n", flags.api_version >> 8, flags.api_version & 0xFF);
@@ -2540,6 +3287,63 @@ lock_timeout(uint8_t delsys)
 
 static uint16_t check_frontend(int fd, int verbose);
 
+static bool frontend_events = false; // --frontend-events
+static __thread fe_status_t frontend_event_status; // status of the latest FE_GET_EVENT since tuning.
+
+/* called after set_frontend(). Without --frontend-events, give the driver some time:
+ * FE_READ_STATUS may still return the status of the previous transponder.
+ * The kernel clears the event queue on tuning, so events are always up to date.
+ */
+static void
+fe_settle(int fd)
+{
+    if (flags.emulate)
+        return;
+    if (frontend_events)
+        frontend_event_status = 0;
+    else
+        unlocked(backend->usleep(100000));
+}
+
+/* wait for a status change, but not beyond timeout. */
+static void
+fe_wait(int fd, struct timespec *timeout)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLPRI };
+    struct timespec now;
+    double remaining;
+
+    if (!frontend_events) {
+        unlocked(backend->usleep(50000));
+        return;
+    }
+    get_time(&now);
+    remaining = elapsed(&now, timeout);
+    if (remaining > 0)
+        unlocked(backend->poll(&pfd, 1, 1 + (int)(remaining * 1000)));
+}
+
+static uint16_t
+fe_status(int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLPRI };
+    struct dvb_frontend_event event;
+
+    if (!frontend_events || flags.emulate)
+        return check_frontend(fd, 0);
+
+    while (backend->poll(&pfd, 1, 0) > 0) {
+        if (backend->ioctl(fd, FE_GET_EVENT, &event) < 0) {
+            if (errno == EOVERFLOW) // events lost, next one is valid.
+                continue;
+            break;
+        }
+        frontend_event_status = event.status;
+        em_record(EM_REC_STATUS, event.status, NULL, 0);
+    }
+    return (frontend_event_status & 0x1F);
+}
+
 static int
 __tune_to_transponder(int frontend_fd, struct transponder *t, int v)
 {
@@ -2564,12 +3368,11 @@ __tune_to_transponder(int frontend_fd, struct transponder *t, int v)
     set_timeout(carrier_timeout(delsys) * flags.tuning_timeout, &timeout); // N msec * {1,2,3}
     ret = 0;
     lastret = ret;
-    if (!flags.emulate)
-        usleep(100000);
+    fe_settle(frontend_fd);
 
     // look for some signal.
     while ((ret & (FE_HAS_SIGNAL | FE_HAS_CARRIER)) == 0) {
-        ret = check_frontend(frontend_fd, 0);
+        ret = fe_status(frontend_fd);
         if (ret != lastret) {
             get_time(&meas_stop);
             verbose(
@@ -2580,15 +3383,15 @@ __tune_to_transponder(int frontend_fd, struct transponder *t, int v)
                 ret & FE_HAS_LOCK ? "L" : "");
             lastret = ret;
         }
-        if (timeout_expired(&timeout) || flags.emulate)
+        if ((ret & (FE_HAS_SIGNAL | FE_HAS_CARRIER)) || timeout_expired(&timeout) || flags.emulate)
             break;
-        usleep(50000);
+        fe_wait(frontend_fd, &timeout);
     }
 
     // now, we should get also lock.
     set_timeout(lock_timeout(delsys) * flags.tuning_timeout, &timeout); // N msec * {1,2,3}
     while ((ret & FE_HAS_LOCK) == 0) {
-        ret = check_frontend(frontend_fd, 0);
+        ret = fe_status(frontend_fd);
         if (ret != lastret) {
             get_time(&meas_stop);
             verbose(
@@ -2599,9 +3402,9 @@ __tune_to_transponder(int frontend_fd, struct transponder *t, int v)
                 ret & FE_HAS_LOCK ? "L" : "");
             lastret = ret;
         }
-        if (timeout_expired(&timeout) || flags.emulate)
+        if ((ret & FE_HAS_LOCK) || timeout_expired(&timeout) || flags.emulate)
             break;
-        usleep(50000);
+        fe_wait(frontend_fd, &timeout);
     }
 
     if (ret & FE_HAS_LOCK) {
@@ -2632,28 +3435,31 @@ __tune_to_transponder(int frontend_fd, struct transponder *t, int v)
     return -1;
 }
 
+/* tune_to_transponder(): st has nearly the same frequency as t. */
+static bool
+is_scanned_frequency(struct transponder *st, void *arg)
+{
+    struct transponder *t = arg;
+
+    if ((flags.scantype == SCAN_SATELLITE) && (t->polarization != st->polarization))
+        return false;
+    return is_nearly_same_frequency(st->frequency, t->frequency, t->type);
+}
+
 static int
 tune_to_transponder(int frontend_fd, struct transponder *t)
 {
-    struct transponder *st;
-    bool known = false;
+    bool known;
 
     /* move TP from "new" to "scanned" list */
-    if (IsMember(new_transponders, t)) {
-        UnlinkItem(new_transponders, t, false);
+    if (tp_index_list(t) == TP_INDEX_NEW) {
+        unlink_tp(new_transponders, t);
     }
 
-    for (st = scanned_transponders->first; st; st = st->next) {
-        if ((flags.scantype == SCAN_SATELLITE) && (t->polarization != st->polarization))
-            continue;
-        if (is_nearly_same_frequency(st->frequency, t->frequency, t->type)) {
-            known = true;
-            break;
-        }
-    }
+    known = tp_index_find_freq(t->frequency, NULL, TP_INDEX_SCANNED, is_scanned_frequency, t) != NULL;
 
     if (known == false) {
-        AddItem(scanned_transponders, t);
+        add_tp(scanned_transponders, t);
     }
 
     if (t->type != flags.scantype) {
@@ -2673,39 +3479,64 @@ tune_to_transponder(int frontend_fd, struct transponder *t)
     }
 }
 
+/* --quick: SDT-other was read completely for t and named all its services, incl. the ones from BAT. */
+static bool
+is_described_transponder(struct transponder *t)
+{
+    struct service *s;
+
+    if (!t->sdt_other_complete || ((t->services)->count == 0))
+        return false;
+    for (s = (t->services)->first; s; s = s->next) {
+        if (s->service_name == NULL)
+            return false;
+    }
+    return true;
+}
+
 static int
 tune_to_next_transponder(int frontend_fd)
 {
     struct transponder *t;
-    uint8_t i, j;
+    struct cell *cell;
+    uint8_t j;
 
     while (new_transponders->count) {
         t = new_transponders->first;
-        i = 0;
+
+        if (quick && is_described_transponder(t)) {
+            verbose(
+                "skipped: (%u:%u:%u), services known from SDT-other (time: %s)\n",
+                t->original_network_id,
+                t->network_id,
+                t->transport_stream_id,
+                run_time());
+            unlink_tp(new_transponders, t);
+            add_tp(scanned_transponders, t);
+            continue;
+        }
 
         if (t->frequency && (tune_to_transponder(frontend_fd, t) == 0))
             return 0;
 
         if (t->other_frequency_flag && ((t->cells)->count > 0)) {
-            while (i < (t->cells)->count) {
+            for (cell = (t->cells)->first; cell; cell = cell->next) {
                 struct transponder *test = NULL;
-                struct cell *next = GetItem(t->cells, i++);
 
-                if (next == NULL)
-                    continue; // GetItem may return NULL; dont want to segfault here.
-
-                t->frequency = next->center_frequencies[0];
+                t->frequency = cell->center_frequencies[0];
+                tp_index_update(t);
                 j = 0;
                 test = find_transponder_by_freq(t);
-                if ((test != NULL) && !(IsMember(scanned_transponders, test))) {
+                if ((test != NULL) && (tp_index_list(test) != TP_INDEX_SCANNED)) {
                     info("retrying with center_frequency = %u\n", t->frequency);
                     if (tune_to_transponder(frontend_fd, t) == 0)
                         return 0;
                 }
-                while (j < next->num_transposers) {
-                    t->frequency = next->transposers[j].transposer_frequency;
+                while (j < cell->num_transposers) {
+                    t->frequency = cell->transposers[j].transposer_frequency;
+                    tp_index_update(t);
                     test = find_transponder_by_freq(t);
-                    if ((test != NULL) && !(IsMember(scanned_transponders, test))) {
+                    if ((test != NULL) && (tp_index_list(test) != TP_INDEX_SCANNED)) {
                         info("retrying with transposer_frequency = %u\n", t->frequency);
                         if (tune_to_transponder(frontend_fd, t) == 0)
                             return 0;
@@ -2713,7 +3544,7 @@ tune_to_next_transponder(int frontend_fd)
                 }
             }
         }
-        if (IsMember(new_transponders, t)) {
+        if (tp_index_list(t) == TP_INDEX_NEW) {
             // moving new_transponders -> scanned_transponders is handled in tune_to_transponder(),
             // but we may pass here w/o calling it. Ensure this tp is moved to scanned_transponders.
             verbose(
@@ -2722,8 +3553,8 @@ tune_to_next_transponder(int frontend_fd)
                 t->network_id,
                 t->transport_stream_id,
                 run_time());
-            UnlinkItem(new_transponders, t, false);
-            AddItem(scanned_transponders, t);
+            unlink_tp(new_transponders, t);
+            add_tp(scanned_transponders, t);
         }
     }
     return -1;
@@ -2734,15 +3565,16 @@ check_frontend(int fd, int verbose)
 {
     fe_status_t status;
     EMUL(em_status, &status)
-    ioctl(fd, FE_READ_STATUS, &status);
+    backend->ioctl(fd, FE_READ_STATUS, &status);
+    em_record(EM_REC_STATUS, status, NULL, 0);
     if (verbose && !flags.emulate) {
         uint16_t snr, signal;
         uint32_t ber, uncorrected_blocks;
 
-        ioctl(fd, FE_READ_SIGNAL_STRENGTH, &signal);
-        ioctl(fd, FE_READ_SNR, &snr);
-        ioctl(fd, FE_READ_BER, &ber);
-        ioctl(fd, FE_READ_UNCORRECTED_BLOCKS, &uncorrected_blocks);
+        backend->ioctl(fd, FE_READ_SIGNAL_STRENGTH, &signal);
+        backend->ioctl(fd, FE_READ_SNR, &snr);
+        backend->ioctl(fd, FE_READ_BER, &ber);
+        backend->ioctl(fd, FE_READ_UNCORRECTED_BLOCKS, &uncorrected_blocks);
         info("signal %04x | snr %04x | ber %08x | unc %08x | ", signal, snr, ber, uncorrected_blocks);
         if (status & FE_HAS_LOCK)
             info("FE_HAS_LOCK");
@@ -2835,8 +3667,9 @@ fe_get_delsys(int frontend_fd, struct transponder *t)
     struct dtv_properties b = { .num = 1, .props = p };
 
     EMUL(em_getproperty, &b)
-    if (ioctl(frontend_fd, FE_GET_PROPERTY, &b) != 0)
+    if (backend->ioctl(frontend_fd, FE_GET_PROPERTY, &b) != 0)
         return 0;
+    em_record(EM_REC_GET_PROPERTY, 0, p, sizeof(p));
 
     // verbose("        %s %d: current delsys %u\n", __FUNCTION__, __LINE__, p[0].u.data);
 
@@ -2883,6 +3716,19 @@ initial_table_lookup(int frontend_fd)
     return true;
 }
 
+/* the transponder after the one taken last by any worker, NULL if none.
+ * new_transponders only grows as long as a worker is in initial_tune().
+ */
+static struct transponder *
+next_initial_transponder(void)
+{
+    struct transponder *t = initial_tp ? initial_tp->next : new_transponders->first;
+
+    if (t != NULL)
+        initial_tp = t;
+    return t;
+}
+
 static int
 initial_tune(int frontend_fd, int tuning_data)
 {
@@ -2972,6 +3818,8 @@ initial_tune(int frontend_fd, int tuning_data)
             }
             for (mod_parm = modulation_min; mod_parm <= modulation_max; mod_parm++) {
                 for (channel = 0; channel <= channel_max; channel++) {
+                    if ((int)(channel % n_workers) != worker_index)
+                        continue; // another worker's channel.
                     for (offs = freq_offset_min; offs <= freq_offset_max; offs++) {
                         for (sr_parm = dvbc_symbolrate_min; sr_parm <= dvbc_symbolrate_max; sr_parm++) {
                             if (flags.scantype == SCAN_TERRESTRIAL) {
@@ -3141,14 +3989,13 @@ initial_tune(int frontend_fd, int tuning_data)
                                 }
                                 get_time(&meas_start);
                                 set_timeout(time2carrier * flags.tuning_timeout, &timeout); // N msec * {1,2,3}
-                                if (!flags.emulate)
-                                    usleep(100000);
+                                fe_settle(frontend_fd);
                                 ret = 0;
                                 lastret = ret;
 
                                 // look for some signal.
                                 while ((ret & (FE_HAS_SIGNAL | FE_HAS_CARRIER)) == 0) {
-                                    ret = check_frontend(frontend_fd, 0);
+                                    ret = fe_status(frontend_fd);
                                     if (ret != lastret) {
                                         get_time(&meas_stop);
                                         verbose(
@@ -3160,9 +4007,9 @@ initial_tune(int frontend_fd, int tuning_data)
                                             ret);
                                         lastret = ret;
                                     }
-                                    if (timeout_expired(&timeout) || flags.emulate)
+                                    if ((ret & (FE_HAS_SIGNAL | FE_HAS_CARRIER)) || timeout_expired(&timeout) || flags.emulate)
                                         break;
-                                    usleep(50000);
+                                    fe_wait(frontend_fd, &timeout);
                                 }
                                 if ((ret & (FE_HAS_SIGNAL | FE_HAS_CARRIER)) == 0) {
                                     switch (test.delsys) {
@@ -3182,7 +4029,7 @@ initial_tune(int frontend_fd, int tuning_data)
                                 set_timeout(time2lock * flags.tuning_timeout, &timeout); // N msec * {1,2,3}
 
                                 while ((ret & FE_HAS_LOCK) == 0) {
-                                    ret = check_frontend(frontend_fd, 0);
+                                    ret = fe_status(frontend_fd);
                                     if (ret != lastret) {
                                         get_time(&meas_stop);
                                         verbose(
@@ -3194,9 +4041,9 @@ initial_tune(int frontend_fd, int tuning_data)
                                             ret);
                                         lastret = ret;
                                     }
-                                    if (timeout_expired(&timeout) || flags.emulate)
+                                    if ((ret & FE_HAS_LOCK) || timeout_expired(&timeout) || flags.emulate)
                                         break;
-                                    usleep(50000);
+                                    fe_wait(frontend_fd, &timeout);
                                 }
                                 if ((ret & FE_HAS_LOCK) == 0) {
                                     switch (test.delsys) {
@@ -3236,10 +4083,10 @@ initial_tune(int frontend_fd, int tuning_data)
                                     // speed up scan NITs and later skipping known transponders.
                                     if (!initial_table_lookup(frontend_fd)) {
                                         info("        deleting (%s)\n", buffer);
-                                        if (IsMember(new_transponders, t))
-                                            DeleteItem(new_transponders, t);
-                                        if (IsMember(scanned_transponders, t))
-                                            DeleteItem(scanned_transponders, t);
+                                        if (tp_index_list(t) == TP_INDEX_NEW)
+                                            delete_tp(new_transponders, t);
+                                        else if (tp_index_list(t) == TP_INDEX_SCANNED)
+                                            delete_tp(scanned_transponders, t);
                                     }
                                     break;
                                 }
@@ -3259,7 +4106,7 @@ initial_tune(int frontend_fd, int tuning_data)
          * network information table. In parallel scan for
          * other transponders provided by NIT actual and NIT other.
          */
-        for (t = new_transponders->first; t; t = t->next) {
+        while ((t = next_initial_transponder()) != NULL) {
             print_transponder(buffer, t);
 
             switch (flags.scantype) {
@@ -3291,12 +4138,13 @@ initial_tune(int frontend_fd, int tuning_data)
                 dprintf(1, "\n%s:%d: Setting frontend failed %s\n", __FUNCTION__, __LINE__, buffer);
                 continue;
             }
-            if (!flags.emulate)
-                usleep(1500000);
-            for (cnt = 0; cnt < 5; cnt++) {
-                if (check_frontend(frontend_fd, 0) == 1)
-                    break;
-                usleep(200000);
+            if (!flags.emulate) {
+                unlocked(backend->usleep(1500000));
+                for (cnt = 0; cnt < 5; cnt++) {
+                    if (check_frontend(frontend_fd, 0) == 1)
+                        break;
+                    unlocked(backend->usleep(200000));
+                }
             }
             if (__tune_to_transponder(frontend_fd, t, 0) >= 0) {
                 info("signal ok\n");
@@ -3305,6 +4153,15 @@ initial_tune(int frontend_fd, int tuning_data)
                 info("\n");
         }
     }
+    /* parallel scan: wait for the other workers, tune_to_next_transponder() takes
+     * transponders out of new_transponders while they may still iterate it.
+     */
+    if (--initial_tuning > 0) {
+        while (initial_tuning > 0)
+            pthread_cond_wait(&scan_cond, &scan_lock);
+    } else
+        pthread_cond_broadcast(&scan_cond);
+
     /* we should now have here a list of well known transponders. Iterate a second time
      * and scan its PAT, PMT, SDT for services. In parallel NIT actual and NIT other.
      */
@@ -3338,6 +4195,21 @@ scan_tp_atsc(void)
     } while ((running_filters->count > 0) || (waiting_filters->count > 0));
 }
 
+/* --quick: SDT-other of the current network may still save tuning one of its transponders. */
+static bool
+want_sdt_other(void)
+{
+    struct transponder *t;
+
+    if (current_tp->network_id && si_cache_complete(TABLE_SDT_OTH, current_tp->network_id))
+        return false; // read before on another transponder of this network.
+    for (t = new_transponders->first; t; t = t->next) {
+        if ((t->network_id == current_tp->network_id) && !t->sdt_other_complete)
+            return true;
+    }
+    return false;
+}
+
 static void
 scan_tp_dvb(void)
 {
@@ -3371,11 +4243,49 @@ scan_tp_dvb(void)
     do {
         read_filters();
     } while ((running_filters->count > 0) || (waiting_filters->count > 0));
+
+    if (quick && want_sdt_other()) {
+        // third run: services of the other transport streams, known from NIT now.
+        setup_filter(&s[0], demux_devname, PID_SDT_BAT_ST, TABLE_SDT_OTH, -1, 1, 1, 0);
+        add_filter(&s[0]);
+        setup_filter(&s[1], demux_devname, PID_SDT_BAT_ST, TABLE_BAT, -1, 1, 1, 0);
+        add_filter(&s[1]);
+        EMUL(em_readfilters, &result)
+        do {
+            read_filters();
+        } while ((running_filters->count > 0) || (waiting_filters->count > 0));
+    }
+}
+
+/* FastScan: the operator's FNT and FST, both on fastscan_pid of the home transponder, describe
+ * all transponders and services. FNT first, FST needs its transponders.
+ */
+static void
+scan_tp_fastscan(void)
+{
+    struct section_buf s;
+    int result = 0;
+
+    reset_table_cycles();
+    setup_filter(&s, demux_devname, fastscan_pid, TABLE_FASTSCAN_FNT, -1, 1, 0, 0);
+    add_filter(&s);
+    EMUL(em_readfilters, &result)
+    do {
+        read_filters();
+    } while ((running_filters->count > 0) || (waiting_filters->count > 0));
+
+    setup_filter(&s, demux_devname, fastscan_pid, TABLE_FASTSCAN_FST, -1, 1, 0, 0);
+    add_filter(&s);
+    EMUL(em_readfilters, &result)
+    do {
+        read_filters();
+    } while ((running_filters->count > 0) || (waiting_filters->count > 0));
 }
 
 static void
 scan_tp(void)
 {
+    reset_table_cycles();
     switch (flags.scantype) {
     case SCAN_SATELLITE:
     case SCAN_CABLE:
@@ -3388,19 +4298,122 @@ scan_tp(void)
     default:
         warning("unimplemented scantype %d.\n", flags.scantype);
     }
+
+    /* intervals are kept per network for the next transponders, and saved with --rate-cache.
+     * original_network_id and network_id 0x0000 are reserved, i.e. not yet known. Without NIT-actual,
+     * the network_id stays unknown: keep those under (original_network_id, 0), as table_interval() asks.
+     */
+    if (current_tp->original_network_id || current_tp->network_id) {
+        int i;
+        for (i = 0; i < 256; i++) {
+            if (table_cycles[i].cycle)
+                rate_cache_put(current_tp->original_network_id, current_tp->network_id, i, table_cycles[i].cycle);
+        }
+    }
 }
 
 static void
 network_scan(int frontend_fd, int tuning_data)
 {
-    if (initial_tune(frontend_fd, tuning_data) < 0) {
+    int tuned = initial_tune(frontend_fd, tuning_data);
+
+    if ((tuned < 0) && (n_workers == 1)) {
         error("Sorry - I couldn't get any working frequency/transponder.\nNothing to scan!\n");
         exit(1);
     }
 
-    do {
-        scan_tp();
-    } while (tune_to_next_transponder(frontend_fd) == 0);
+    for (;;) {
+        while (tuned == 0) {
+            scan_tp();
+            scanned_count++;
+            pthread_cond_broadcast(&scan_cond); // may have found new transponders.
+            tuned = tune_to_next_transponder(frontend_fd);
+        }
+        // nothing left for now, but busy workers may still find new transponders.
+        busy_workers--;
+        while ((new_transponders->count == 0) && (busy_workers > 0))
+            pthread_cond_wait(&scan_cond, &scan_lock);
+        if (new_transponders->count == 0) {
+            pthread_cond_broadcast(&scan_cond);
+            break;
+        }
+        busy_workers++;
+        tuned = tune_to_next_transponder(frontend_fd);
+    }
+}
+
+/* the home transponder is the first initial transponder carrying FastScan tables;
+ * the transponders from its FNT are not tuned.
+ */
+static void
+fast_scan(int frontend_fd, int tuning_data)
+{
+    struct transponder *t, *next;
+    uint32_t services = 0;
+    int i;
+
+    if (tuning_data <= 0) {
+        for (i = 0; i < sat_list[this_channellist].item_count; i++) {
+            struct __sat_transponder const *item = &sat_list[this_channellist].items[i];
+
+            if ((item->modulation_system == SYS_DVBS2) &&
+                (!(fe_info.caps & FE_CAN_2G_MODULATION) || (flags.api_version < 0x0500)))
+                continue;
+            t = alloc_transponder(item->intermediate_frequency * 1000, item->modulation_system, item->polarization);
+            t->inversion = caps_inversion;
+            t->symbolrate = item->symbol_rate * 1000;
+            t->coderate = item->fec_inner;
+            t->modulation = item->modulation_type;
+            t->pilot = PILOT_AUTO;
+            t->rolloff = item->rolloff;
+            t->orbital_position = sat_list[this_channellist].orbital_position;
+            t->west_east_flag = sat_list[this_channellist].west_east_flag;
+        }
+    }
+
+    while ((services == 0) && ((t = new_transponders->first) != NULL)) {
+        if (tune_to_transponder(frontend_fd, t) != 0)
+            continue;
+        scan_tp_fastscan();
+        scanned_count++;
+        for (t = scanned_transponders->first; t; t = t->next)
+            services += (t->services)->count;
+        for (t = new_transponders->first; t; t = t->next)
+            services += (t->services)->count;
+        if (services == 0)
+            info("no FastScan services on pid %d.\n", fastscan_pid);
+    }
+    if (services == 0) {
+        error("Sorry - no FastScan tables found on pid %d.\n", fastscan_pid);
+        exit(1);
+    }
+    info("FastScan: %u services.\n", services);
+
+    for (t = new_transponders->first; t; t = next) {
+        next = t->next;
+        if ((t->source >> 8) == TABLE_FASTSCAN_FNT) {
+            unlink_tp(new_transponders, t);
+            add_tp(scanned_transponders, t);
+        } else
+            delete_tp(new_transponders, t); // initial transponder, not in FNT.
+    }
+}
+
+static void *
+scan_worker(void *arg)
+{
+    struct scan_worker *w = arg;
+
+    worker_index = w - scan_workers;
+    snprintf(demux_devname, sizeof(demux_devname), "%s", w->demux_devname);
+    init_filter_lists();
+    pthread_mutex_lock(&scan_lock);
+    if (userspace_demux && ((ts_demux = ts_demux_open(demux_devname)) == NULL))
+        warning("%s: userspace demux not available, using kernel section filters.\n", demux_devname);
+    network_scan(w->frontend_fd, w->tuning_data);
+    close_filter_devices();
+    pthread_mutex_unlock(&scan_lock);
+    return NULL;
 }
 
 int
@@ -3429,10 +4442,11 @@ get_api_version(int frontend_fd, struct w_scan_flags *flags)
     /* expected to fail with old drivers,
      * therefore no warning to user. 20090324 -wk
      */
-    if (ioctl(frontend_fd, FE_GET_PROPERTY, &cmdseq))
+    if (backend->ioctl(frontend_fd, FE_GET_PROPERTY, &cmdseq))
         return -1;
 
     flags->api_version = p[0].u.data;
+    em_record(EM_REC_API_VERSION, flags->api_version, NULL, 0);
     return 0;
 }
 
@@ -3451,28 +4465,29 @@ cmp_freq_pol(void *a, void *b)
     return 0;
 }
 
-void
-bubbleSort(pList list, cmp_func compare)
+/* serv_select bit of s: 1 = TV, 2 = radio, 4 = data/other. */
+static unsigned int
+service_kind(struct service const *s)
 {
-    if (compare == NULL) {
-        warning("sort function not assigned.\n");
-        return;
-    }
-
-    unsigned i, j;
-    for (i = 0; i < list->count; i++) {
-        bool swapped = false;
-        for (j = 0; j < list->count - i - 1; j++) {
-            void *a = GetItem(list, j), *b = GetItem(list, j + 1);
-            if (compare(a, b) > 0) {
-                UnlinkItem(list, b, 0);
-                InsertItem(list, b, ((pItem)a)->index);
-                swapped = true;
-            }
+    if (s->video_pid) // vpid, this is tv
+        return 1;
+    if (s->audio_num || s->ac3_num) // no vpid, but apid or ac3pid, this is radio
+        return 2;
+    if (quick) { // --quick: services of transponders, which were not tuned, have only their service_type.
+        switch (s->type) { // EN 300 468 Table 87, service_type
+        case 0x01:
+        case 0x11:
+        case 0x16 ... 0x19:
+        case 0x1F:
+            return 1;
+        case 0x02:
+        case 0x07:
+        case 0x0A:
+            return 2;
+        default:;
         }
-        if (!swapped)
-            return;
     }
+    return 4; // no vpid, no apid, no ac3pid, this is service/other
 }
 
 static void
@@ -3484,17 +4499,16 @@ dump_lists(int adapter, int frontend)
     char sn[20];
     FILE *dest = flags.emulate ? stderr : stdout; // no fprintf output to stdout /w emul. why? :(
 
-    if (verbosity > 4)
-        bubbleSort(scanned_transponders, cmp_freq_pol);
+    if (verbosity > 4) {
+        SortList(scanned_transponders, cmp_freq_pol);
+        for (t = scanned_transponders->first; t; t = t->next)
+            tp_index_add(t, TP_INDEX_SCANNED); // follow the new list order.
+    }
 
     for (t = scanned_transponders->first; t; t = t->next) {
         for (s = (t->services)->first; s; s = s->next) {
-            if (s->video_pid && !(serv_select & 1))
-                continue; /* no TV services */
-            if (!s->video_pid && (s->audio_num || s->ac3_num) && !(serv_select & 2))
-                continue; /* no radio services */
-            if (!s->video_pid && !(s->audio_num || s->ac3_num) && !(serv_select & 4))
-                continue; /* no data/other services */
+            if (!(service_kind(s) & serv_select))
+                continue; /* no TV, radio or data/other services */
             if (s->scrambled && (flags.ca_select == 0))
                 continue; /* FTA only */
             n++;
@@ -3550,14 +4564,8 @@ dump_lists(int adapter, int frontend)
                 if (s->provider_name[i] == ':')
                     s->provider_name[i] = ' ';
             }
-            if (s->video_pid && !(serv_select & 1)) // vpid, this is tv
-                continue; /* no TV services */
-            if (!s->video_pid && (s->audio_num || s->ac3_num) && !(serv_select & 2)) // no vpid, but apid or ac3pid, this is
-                                                                                     // radio
-                continue; /* no radio services */
-            if (!s->video_pid && !(s->audio_num || s->ac3_num) && !(serv_select & 4)) // no vpid, no apid, no ac3pid, this is
-                                                                                      // service/other
-                continue; /* no data/other services */
+            if (!(service_kind(s) & serv_select))
+                continue; /* no TV, radio or data/other services */
             if (s->scrambled && (flags.ca_select == 0)) // caid, this is scrambled tv or radio
                 continue; /* FTA only */
             switch (output_format) {
@@ -3594,6 +4602,8 @@ handle_sigint(int sig)
 {
     error("interrupted by SIGINT, dumping partial result...\n");
     dump_lists(-1, -1);
+    if (rate_cache_file)
+        rate_cache_save(rate_cache_file);
     exit(2);
 }
 
@@ -3606,8 +4616,9 @@ fe_supports_scan(int fd, scantype_t type, struct dvb_frontend_info info)
 
     if (flags.api_version >= 0x0505) {
         EMUL(em_getproperty, &cmdseq)
-        if (ioctl(fd, FE_GET_PROPERTY, &cmdseq) < 0)
+        if (backend->ioctl(fd, FE_GET_PROPERTY, &cmdseq) < 0)
             return 0;
+        em_record(EM_REC_GET_PROPERTY, 0, p, sizeof(p));
 
         verbose("   check %s:\n", info.name);
 
@@ -3657,11 +4668,38 @@ fe_supports_scan(int fd, scantype_t type, struct dvb_frontend_info info)
         default:
             return 0;
         }
-        return (ioctl(fd, FE_SET_PROPERTY, &cmdseq) == 0);
+        return (backend->ioctl(fd, FE_SET_PROPERTY, &cmdseq) == 0);
     }
     return false; // unsupported
 }
 
+/* --parallel: adds a worker for each other adapter with a frontend of the same type.
+ * Only the first frontend and demux of each adapter is used.
+ */
+static void
+find_parallel_frontends(int adapter, scantype_t scantype)
+{
+    struct dvb_frontend_info fi;
+    char devname[80];
+    int i, fd;
+
+    for (i = 0; (i < MAX_WORKERS) && ((parallel == 0) || (n_workers < parallel)); i++) {
+        if (i == adapter)
+            continue;
+        snprintf(devname, sizeof(devname), "/dev/dvb/adapter%i/frontend0", i);
+        if ((fd = backend->open(devname, O_RDWR)) < 0)
+            continue;
+        if ((backend->ioctl(fd, FE_GET_INFO, &fi) == -1) || !fe_supports_scan(fd, scantype, fi)) {
+            backend->close(fd);
+            continue;
+        }
+        info("parallel scan: using %s \"%s\"\n", devname, fi.name);
+        scan_workers[n_workers].frontend_fd = fd;
+        snprintf(scan_workers[n_workers].demux_devname, sizeof(scan_workers[0].demux_devname), "/dev/dvb/adapter%i/demux0", i);
+        n_workers++;
+    }
+}
+
 static char const *usage =
     "\n"
     "usage: %s [options...] \n"
@@ -3741,12 +4779,48 @@ static char const *ext_opts =
     "               regardless of the signal strength, so if you are in an area\n"
     "               with the same transponders being broadcast from different sources,\n"
     "               this will prevent you from searching for services in all of them\n"
+    "       --quick\n"
+    "               also read SDT-other and BAT and don't tune transponders, whose\n"
+    "               services are all known from there. These services have no pids,\n"
+    "               TV and radio are told apart by service type.\n"
     ".................Device..................\n"
     "       -a N, --adapter N\n"
     "               use device /dev/dvb/adapterN/ [default: auto detect]\n"
     "               (also allowed: -a /dev/dvb/adapterN/frontendM)\n"
     "       -F, --long-demux-timeout\n"
     "               use long filter timeout\n"
+    "       --userspace-demux\n"
+    "               read all tables through one raw TS filter and assemble\n"
+    "               sections in w_scan2 instead of one kernel section filter per\n"
+    "               table. Reads all PMTs of a transponder at once.\n"
+    "       --frontend-events\n"
+    "               wait for frontend status events (FE_GET_EVENT) while\n"
+    "               tuning instead of polling the status every 50 msec\n"
+    "       --parallel N\n"
+    "               scan with up to N frontends of different adapters at once,\n"
+    "               0 = all suitable frontends. Needs adapter auto detection.\n"
+    "       --rate-cache FILE\n"
+    "               measure how often each network repeats its tables, store\n"
+    "               this in FILE and use it for shorter filter timeouts in\n"
+    "               later scans\n"
+    "       --capture FILE\n"
+    "               record all frontend settings, status and sections in FILE,\n"
+    "               which can be replayed later by -a FILE\n"
+    "       --ts FILE\n"
+    "               scan a recorded transport stream FILE instead of a dvb device,\n"
+    "               tuning data of FILE in initial tuning data format is read\n"
+    "               from FILE.conf or, for FILE.ts, from FILE.conf w/o '.ts'.\n"
+    "               Repeat for more transponders.\n"
+    "       --replay-speed N\n"
+    "               replaying with -a FILE: 0 = as fast as possible [default],\n"
+    "               1 = real-time, N = N times faster than captured\n"
+    "       --simulate SPEC\n"
+    "               scan a simulated DVB-C network on a virtual clock instead of\n"
+    "               a dvb device, reports the scan time of this network. SPEC is a\n"
+    "               comma separated list of tps=N, services=N (per transponder),\n"
+    "               lock=MSEC, pat=MSEC, pmt=MSEC, nit=MSEC, sdt=MSEC (repetition\n"
+    "               intervals), crc=PERCENT (sections with CRC errors) and seed=N,\n"
+    "               e.g. 'tps=8,lock=300,crc=2'. See also 'make bench'.\n"
     "       -t N, --lock-timeout N\n"
     "               tuning timeout\n"
     "               1 = fastest\n"
@@ -3806,6 +4880,11 @@ static char const *ext_opts =
     "               use DiSEqC rotor Position file\n"
     "       -r N, --rotor-position N\n"
     "               use Rotor position N (needs -s)\n"
+    "       --fastscan PID\n"
+    "               read the operator's FastScan tables (FNT, FST) on PID of the\n"
+    "               first initial transponder carrying them and take all\n"
+    "               transponders and services from there, w/o tuning them.\n"
+    "               i.e. 900 for Canal Digitaal, 910 TV Vlaanderen, 920 TeleSAT\n"
     "       -u    <slot:user_frequency:sat_pos(:user_pin)>\n"
     "       --scr <slot:user_frequency:sat_pos(:user_pin)>\n"
     "               Satellite Channel Routing\n"
@@ -3845,6 +4924,20 @@ static char const *ext_opts =
     "               do not use ATSC PSIP tables for scanning\n"
     "               (but only PAT and PMT) (applies for ATSC only)\n";
 
+/* values of long-only options, other than 0 (input-charset). */
+enum __long_only_options {
+    OPT_USERSPACE_DEMUX = 256,
+    OPT_RATE_CACHE,
+    OPT_FRONTEND_EVENTS,
+    OPT_PARALLEL,
+    OPT_FASTSCAN,
+    OPT_QUICK,
+    OPT_CAPTURE,
+    OPT_REPLAY_SPEED,
+    OPT_TS,
+    OPT_SIMULATE,
+};
+
 /*no_argument, required_argument and optional_argument. */
 static struct option long_options[] = {
     { "frontend", required_argument, NULL, 'f' },
@@ -3886,6 +4979,16 @@ static struct option long_options[] = {
     { "scr", required_argument, NULL, 'u' },
     { "use-pat", required_argument, NULL, 'P' },
     { "delete-duplicate-transponders", no_argument, NULL, 'd' },
+    { "userspace-demux", no_argument, NULL, OPT_USERSPACE_DEMUX },
+    { "rate-cache", required_argument, NULL, OPT_RATE_CACHE },
+    { "frontend-events", no_argument, NULL, OPT_FRONTEND_EVENTS },
+    { "parallel", required_argument, NULL, OPT_PARALLEL },
+    { "fastscan", required_argument, NULL, OPT_FASTSCAN },
+    { "quick", no_argument, NULL, OPT_QUICK },
+    { "capture", required_argument, NULL, OPT_CAPTURE },
+    { "replay-speed", required_argument, NULL, OPT_REPLAY_SPEED },
+    { "ts", required_argument, NULL, OPT_TS },
+    { "simulate", required_argument, NULL, OPT_SIMULATE },
     { "version", no_argument, NULL, 'V' },
     { NULL, 0, NULL, 0 },
 };
@@ -3919,6 +5022,7 @@ main(int argc, char **argv)
     int adapter = DVB_ADAPTER_AUTO, frontend = 0, demux = 0;
     int opt;
     unsigned int i = 0, j;
+    int w;
     int frontend_fd = -1;
     int fe_open_mode;
     uint16_t scantype = SCAN_TERRESTRIAL;
@@ -3939,12 +5043,11 @@ main(int argc, char **argv)
     char sw_type = 0;
 
     // initialize lists.
-    NewList(running_filters, "running_filters");
-    NewList(waiting_filters, "waiting_filters");
+    init_filter_lists();
     NewList(scanned_transponders, "scanned_transponders");
     NewList(new_transponders, "new_transponders");
 
-#define cleanup() cl(country); cl(satellite); cl(initdata); cl(positionfile); cl(codepage);
+#define cleanup() cl(country); cl(satellite); cl(initdata); cl(positionfile); cl(codepage); close_filter_devices();
 
     this_lnb = *lnb_enum(0);
     this_lnb.low_val *= 1000;
@@ -4208,6 +5311,53 @@ main(int argc, char **argv)
         case 0: // input-charset (long-only)
             flags.fallback_input_charset = optarg;
             break;
+        case OPT_USERSPACE_DEMUX:
+            userspace_demux = true;
+            break;
+        case OPT_RATE_CACHE:
+            rate_cache_file = optarg;
+            break;
+        case OPT_FRONTEND_EVENTS:
+            frontend_events = true;
+            break;
+        case OPT_PARALLEL:
+            parallel = strtol(optarg, NULL, 0);
+            if ((parallel < 0) || (parallel > MAX_WORKERS))
+                fatal("--parallel: need 0 (all) or 1..%d frontends.\n", MAX_WORKERS);
+            break;
+        case OPT_FASTSCAN:
+            fastscan_pid = strtol(optarg, NULL, 0);
+            if ((fastscan_pid < 0x10) || (fastscan_pid > 0x1FFE))
+                fatal("--fastscan: invalid pid %s.\n", optarg);
+            break;
+        case OPT_QUICK:
+            quick = true;
+            break;
+        case OPT_CAPTURE:
+            capture_file = optarg;
+            break;
+        case OPT_REPLAY_SPEED:
+            em_replay_speed(strtod(optarg, NULL));
+            break;
+        case OPT_TS:
+            if (!flags.emulate) {
+                adapter = 9999, frontend = 0;
+                flags.emulate = 1;
+                em_init(NULL);
+            }
+            if ((ts_files = realloc(ts_files, (n_ts_files + 1) * sizeof(char *))) == NULL)
+                fatal("Could not allocate memory.\n");
+            ts_files[n_ts_files++] = optarg;
+            break;
+        case OPT_SIMULATE:
+            if (!sim_configure(optarg)) {
+                bad_usage(argv[0]);
+                cleanup();
+                return -1;
+            }
+            backend = &backend_sim;
+            run_time_init(); // scan time on the virtual clock.
+            break;
         case 'D': // DiSEqC committed/uncommitted switch
             sscanf(optarg, "%u%c", &i, &sw_type);
             switch (sw_type) {
@@ -4307,7 +5457,7 @@ main(int argc, char **argv)
         cleanup();
         return 0;
     }
-    if (NULL == initdata) {
+    if ((NULL == initdata) && (n_ts_files == 0)) {
         if ((NULL == country) && (scantype != SCAN_SATELLITE)) {
             country = strdup(country_to_short_name(get_user_country()));
             info("guessing country '%s', use -c <country> to override\n", country);
@@ -4330,6 +5480,17 @@ main(int argc, char **argv)
         cleanup();
         return -1;
     }
+    if (capture_file) {
+        if (flags.emulate) {
+            cleanup();
+            fatal("--capture needs a dvb device, not -a FILE.\n");
+        }
+        em_capture(capture_file);
+    }
+    if (flags.emulate && (backend != &backend_dvb)) {
+        cleanup();
+        fatal("--simulate replaces the dvb device, not together with -a FILE or --ts FILE.\n");
+    }
     switch (scantype) {
     case SCAN_TERRCABLE_ATSC:
     case SCAN_CABLE:
@@ -4402,6 +5563,28 @@ main(int argc, char **argv)
             sleep(10); // enshure that user reads warning.
         }
     }
+    for (i = 0; i < n_ts_files; i++) {
+        char *conf = (char *)calloc(strlen(ts_files[i]) + 6, sizeof(char));
+        uint32_t count = new_transponders->count;
+        size_t len = strlen(ts_files[i]);
+
+        strcpy(conf, ts_files[i]);
+        if ((len > 3) && (strcmp(conf + len - 3, ".ts") == 0))
+            conf[len - 3] = 0;
+        strcat(conf, ".conf");
+        if (dvbscan_parse_tuningdata(conf, &flags) == 0) {
+            cleanup();
+            fatal("%s: could not read tuning data from %s.\n", ts_files[i], conf);
+        }
+        free(conf);
+        if (new_transponders->count != count + 1) {
+            cleanup();
+            fatal("%s: need exactly one new transponder in tuning data.\n", ts_files[i]);
+        }
+        em_add_tsfile(ts_files[i], new_transponders->last);
+        scantype = flags.scantype;
+        valid_initial_data = 1;
+    }
     if (scantype == SCAN_TERRESTRIAL) {
         info(
             "scan type %s, delivery system %s, channellist %d\n",
@@ -4463,6 +5646,7 @@ main(int argc, char **argv)
         cleanup();
         fatal("unhandled output format %d\n", output_format);
     }
+    init_descriptor_filter();
     if (codepage) {
         flags.codepage = get_codepage_index(codepage);
         info("output charset '%s'\n", iconv_codes[flags.codepage]);
@@ -4470,19 +5654,20 @@ main(int argc, char **argv)
         flags.codepage = get_user_codepage();
         info("output charset '%s', use -C <charset> to override\n", iconv_codes[flags.codepage]);
     }
+    auto_adapter = adapter == DVB_ADAPTER_AUTO;
     if (adapter == DVB_ADAPTER_AUTO) {
         info("Info: using DVB adapter auto detection.\n");
         fe_open_mode = O_RDWR | O_NONBLOCK;
         for (i = 0; i < DVB_ADAPTER_SCAN; i++) {
             for (j = 0; j < 4; j++) {
                 snprintf(frontend_devname, sizeof(frontend_devname), "/dev/dvb/adapter%i/frontend%i", i, j);
-                if ((frontend_fd = open(frontend_devname, fe_open_mode)) < 0) {
+                if ((frontend_fd = backend->open(frontend_devname, fe_open_mode)) < 0) {
                     continue;
                 }
                 /* determine FE type and caps */
-                if (ioctl(frontend_fd, FE_GET_INFO, &fe_info) == -1) {
+                if (backend->ioctl(frontend_fd, FE_GET_INFO, &fe_info) == -1) {
                     info("   ERROR: unable to determine frontend type\n");
-                    close(frontend_fd);
+                    backend->close(frontend_fd);
                     continue;
                 }
 
@@ -4513,14 +5698,14 @@ main(int argc, char **argv)
                     } else {
                         info("usable, but not preferred\n");
                     }
-                    close(frontend_fd);
+                    backend->close(frontend_fd);
                 } else {
                     info(
                         "\t%s -> \"%s\" doesnt support %s -> SEARCH NEXT ONE.\n",
                         frontend_devname,
                         fe_info.name,
                         scantype_to_text(scantype));
-                    close(frontend_fd);
+                    backend->close(frontend_fd);
                 }
             } // END: for j
         } // END: for i
@@ -4532,9 +5717,6 @@ main(int argc, char **argv)
     snprintf(frontend_devname, sizeof(frontend_devname), "/dev/dvb/adapter%i/frontend%i", adapter, frontend);
     snprintf(demux_devname, sizeof(demux_devname), "/dev/dvb/adapter%i/demux%i", adapter, demux);
 
-    for (i = 0; i < MAX_RUNNING; i++)
-        poll_fds[i].fd = -1;
-
     fe_open_mode = O_RDWR;
     if (adapter == DVB_ADAPTER_AUTO) {
         cleanup();
@@ -4545,17 +5727,18 @@ main(int argc, char **argv)
             scantype_to_text(scantype));
     }
     EMUL(em_open, &frontend_fd)
-    if ((frontend_fd = open(frontend_devname, fe_open_mode)) < 0) {
+    if ((frontend_fd = backend->open(frontend_devname, fe_open_mode)) < 0) {
         cleanup();
         fatal("failed to open '%s': %d %s\n", frontend_devname, errno, strerror(errno));
     }
     info("-_-_-_-_ Getting frontend capabilities-_-_-_-_ \n");
     /* determine FE type and caps */
     EMUL(em_info, &fe_info)
-    if (ioctl(frontend_fd, FE_GET_INFO, &fe_info) == -1) {
+    if (backend->ioctl(frontend_fd, FE_GET_INFO, &fe_info) == -1) {
         cleanup();
         fatal("FE_GET_INFO failed: %d %s\n", errno, strerror(errno));
     }
+    em_record(EM_REC_FE_INFO, 0, &fe_info, sizeof(fe_info));
     flags.scantype = scantype;
 
     EMUL(em_dvbapi, &flags.api_version)
@@ -4750,9 +5933,61 @@ main(int argc, char **argv)
         fatal("Frontend '%s' doesnt support your choosen scan type '%s'\n", fe_info.name, scantype_to_text(scantype));
     }
 
+    if (userspace_demux && (backend != &backend_dvb)) {
+        info("userspace demux is not simulated, using section filters.\n");
+        userspace_demux = false;
+    }
+    if (userspace_demux && !flags.emulate) {
+        if ((ts_demux = ts_demux_open(demux_devname)) == NULL) {
+            warning("userspace demux not available, using kernel section filters.\n");
+            userspace_demux = false;
+        }
+    }
+
+    if ((fastscan_pid >= 0) && (scantype != SCAN_SATELLITE)) {
+        cleanup();
+        fatal("--fastscan needs satellite scan type (-f s).\n");
+    }
+
+    if (rate_cache_file)
+        rate_cache_load(rate_cache_file);
+
+    if (parallel >= 0) {
+        if (!auto_adapter || flags.emulate || (backend != &backend_dvb) || (scr_config.user_frequency > 0) ||
+            flags.delete_duplicate_transponders || (fastscan_pid >= 0) || capture_file ||
+            ((scantype == SCAN_SATELLITE) && (sat_list[this_channellist].rotor_position > -1)))
+            info("parallel scan needs adapter auto detection of dvb devices, w/o SCR, rotor, -d, --fastscan and --capture;"
+                 " using one frontend.\n");
+        else
+            find_parallel_frontends(adapter, scantype);
+    }
+    busy_workers = initial_tuning = n_workers;
+
     signal(SIGINT, handle_sigint);
-    network_scan(frontend_fd, valid_initial_data);
-    close(frontend_fd);
+    pthread_mutex_lock(&scan_lock);
+    for (w = 1; w < n_workers; w++) {
+        int err;
+
+        scan_workers[w].tuning_data = valid_initial_data;
+        if ((err = pthread_create(&scan_workers[w].thread, NULL, scan_worker, &scan_workers[w])) != 0)
+            fatal("pthread_create failed: %d %s\n", err, strerror(err));
+    }
+    if (fastscan_pid >= 0)
+        fast_scan(frontend_fd, valid_initial_data);
+    else
+        network_scan(frontend_fd, valid_initial_data);
+    pthread_mutex_unlock(&scan_lock);
+    for (w = 1; w < n_workers; w++) {
+        pthread_join(scan_workers[w].thread, NULL);
+        backend->close(scan_workers[w].frontend_fd);
+    }
+    if ((n_workers > 1) && (scanned_count == 0)) {
+        error("Sorry - I couldn't get any working frequency/transponder.\nNothing to scan!\n");
+        exit(1);
+    }
+    backend->close(frontend_fd);
+    if (rate_cache_file)
+        rate_cache_save(rate_cache_file);
     dump_lists(adapter, frontend);
     cleanup();
     return 0;
@@ -63,6 +63,7 @@ struct w_scan_flags {
 
 struct service *find_service(struct transponder *t, uint16_t service_id);
 struct service *alloc_service(struct transponder *t, uint16_t service_id);
+void free_service_table(struct transponder *t);
 
 struct transponder *alloc_transponder(uint32_t frequency, unsigned delsys, uint8_t polarization);
 
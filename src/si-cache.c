@@ -0,0 +1,172 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "si-cache.h"
+
+struct si_key {
+    uint32_t crc;
+    uint16_t table_id_ext;
+    uint8_t table_id;
+    uint8_t section_number;
+    uint8_t version; // version_number + 1, 0 == unused slot.
+    bool parsed; // see si_cache_set_parsed()
+    uint32_t value;
+};
+
+static struct si_key *keys = NULL; // open addressing, size is a power of two.
+static uint32_t keys_size = 0;
+static uint32_t keys_used = 0;
+
+static uint32_t *complete = NULL; // table_id << 16 | network_id
+static uint32_t complete_count = 0;
+
+static uint32_t
+key_hash(struct si_key const *k)
+{
+    uint32_t h = k->crc ^ (k->table_id_ext * 0x9E3779B1U) ^ (k->table_id << 24) ^ (k->section_number << 16);
+    return h ^ (h >> 15);
+}
+
+static bool
+key_equal(struct si_key const *a, struct si_key const *b)
+{
+    return (a->crc == b->crc) && (a->table_id_ext == b->table_id_ext) && (a->table_id == b->table_id) &&
+           (a->section_number == b->section_number) && (a->version == b->version);
+}
+
+/* returns the slot of k, or the empty slot where it belongs. */
+static struct si_key *
+key_slot(struct si_key const *k)
+{
+    uint32_t i = key_hash(k) & (keys_size - 1);
+
+    while (keys[i].version && !key_equal(&keys[i], k))
+        i = (i + 1) & (keys_size - 1);
+    return &keys[i];
+}
+
+static void
+grow(void)
+{
+    struct si_key *old = keys;
+    uint32_t i, old_size = keys_size;
+
+    keys_size = keys_size ? 2 * keys_size : 256;
+    keys = calloc(keys_size, sizeof(struct si_key));
+    for (i = 0; i < old_size; i++) {
+        if (old[i].version)
+            *key_slot(&old[i]) = old[i];
+    }
+    free(old);
+}
+
+static void
+section_key(unsigned char const *section, int length, struct si_key *k)
+{
+    k->table_id = section[0];
+    k->table_id_ext = (section[3] << 8) | section[4];
+    k->version = ((section[5] >> 1) & 0x1F) + 1;
+    k->section_number = section[6];
+    k->crc = (section[length - 4] << 24) | (section[length - 3] << 16) | (section[length - 2] << 8) | section[length - 1];
+    k->parsed = false;
+    k->value = 0;
+}
+
+/* returns the slot of section, which is added if not yet known. */
+static struct si_key *
+section_slot(unsigned char const *section, int length, bool *known)
+{
+    struct si_key k, *slot;
+
+    section_key(section, length, &k);
+    if (2 * (keys_used + 1) > keys_size) // keep load factor <= 0.5
+        grow();
+    slot = key_slot(&k);
+    *known = slot->version != 0;
+    if (!*known) {
+        *slot = k;
+        keys_used++;
+    }
+    return slot;
+}
+
+bool
+si_cache_section(unsigned char const *section, int length)
+{
+    bool known;
+
+    if (length < 12)
+        return false;
+    section_slot(section, length, &known);
+    return known;
+}
+
+bool
+si_cache_parsed(unsigned char const *section, int length, uint32_t *value)
+{
+    struct si_key k, *slot;
+
+    if ((length < 12) || (keys_size == 0))
+        return false;
+    section_key(section, length, &k);
+    slot = key_slot(&k);
+    if (!slot->version || !slot->parsed)
+        return false;
+    *value = slot->value;
+    return true;
+}
+
+void
+si_cache_set_parsed(unsigned char const *section, int length, uint32_t value)
+{
+    struct si_key *slot;
+    bool known;
+
+    if (length < 12)
+        return;
+    slot = section_slot(section, length, &known);
+    slot->parsed = true;
+    slot->value = value;
+}
+
+void
+si_cache_set_complete(uint8_t table_id, uint16_t network_id)
+{
+    if (si_cache_complete(table_id, network_id))
+        return;
+    complete = realloc(complete, (complete_count + 1) * sizeof(uint32_t));
+    complete[complete_count++] = (table_id << 16) | network_id;
+}
+
+bool
+si_cache_complete(uint8_t table_id, uint16_t network_id)
+{
+    uint32_t i;
+
+    for (i = 0; i < complete_count; i++) {
+        if (complete[i] == (uint32_t)((table_id << 16) | network_id))
+            return true;
+    }
+    return false;
+}
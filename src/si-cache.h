@@ -0,0 +1,54 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#ifndef __SI_CACHE_H__
+#define __SI_CACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * all SI sections seen during a scan, identified by table_id, table_id_ext,
+ * version_number, section_number and CRC32. Tables like NIT-other are broadcast
+ * identically on all transponders of a network, so their sections are seen
+ * again and again.
+ */
+
+/* section points to table_id, length is the full section incl. CRC32.
+ * returns true, if an identical section was seen before; otherwise it's added.
+ */
+bool si_cache_section(unsigned char const *section, int length);
+
+/* sections, which don't depend on the current transponder, need to be parsed once per scan.
+ * On a repeat, only their effect on the current transponder has to be applied again,
+ * which the parser saved as value.
+ * si_cache_parsed() returns true and sets value, if section was parsed before.
+ */
+bool si_cache_parsed(unsigned char const *section, int length, uint32_t *value);
+void si_cache_set_parsed(unsigned char const *section, int length, uint32_t value);
+
+/* network_id (from NIT-actual) was scanned with a full filter timeout for table_id,
+ * i.e. its sections of table_id are all in the cache.
+ */
+void si_cache_set_complete(uint8_t table_id, uint16_t network_id);
+bool si_cache_complete(uint8_t table_id, uint16_t network_id);
+
+#endif
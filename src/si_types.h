@@ -39,11 +39,12 @@ struct section_buf {
     /*----------------------------*/
     void *prev;
     void *next;
-    uint32_t index;
+    pList list;
     /*----------------------------*/
     char const *dmx_devname;
     unsigned int run_once : 1;
     unsigned int segmented : 1; // segmented by table_id_ext
+    unsigned int known_cycle : 1; // segmented: a full cycle brought no new sections, see parse_section()
     int fd;
     int pid;
     int table_id;
@@ -53,9 +54,12 @@ struct section_buf {
     int sectionfilter_done;
     unsigned char buf[SECTION_BUF_SIZE];
     uint32_t flags;
-    time_t timeout;
-    time_t start_time;
-    time_t running_time;
+    uint32_t timeout; // msec
+    int64_t start_time; // msec, see filter_clock()
+    int64_t deadline; // msec, start_time + timeout, maybe earlier once the table's repetition is seen.
+    uint32_t running_time; // msec
+    unsigned run; // numbers each start of the filter, see observe_section().
+    uint32_t quiet_crc; // segmented: CRC of the first section after which only known sections arrived.
     struct section_buf *next_seg; // this is used to handle segmented tables (like NIT-other)
     pList garbage;
 };
@@ -74,7 +78,7 @@ struct service {
     /*----------------------------*/
     void *prev;
     void *next;
-    uint32_t index;
+    pList list;
     /*----------------------------*/
     struct transponder *transponder;
     uint16_t transport_stream_id;
@@ -125,7 +129,7 @@ struct cell {
     /*----------------------------*/
     void *prev;
     void *next;
-    uint32_t index;
+    pList list;
     /*----------------------------*/
     uint16_t cell_id;
 
@@ -141,9 +145,12 @@ struct transponder {
     /*----------------------------*/
     void *prev;
     void *next;
-    uint32_t index;
+    pList list;
     pList services;
     cList _services;
+    struct service **service_table; /* services by service_id, see find_service() */
+    uint32_t service_table_size; /* power of two, 0 == none yet */
+    uint32_t service_table_count;
     pList cells; /* DVB-T/T2 */
     cList _cells;
     /*----------------------------- starting from here copied by 'copy_fe_params' ------------------------------------------*/
@@ -197,6 +204,8 @@ struct transponder {
     /*----------------------------*/
     char *network_name;
     network_change_t network_change;
+    bool sdt_other_complete; // all sections of SDT-other seen for this transport stream, see --quick.
+    struct tp_index_entry *tp_index; // see tp-index.h, NULL if not in scanned/new_transponders.
 };
 
 /*******************************************************************************
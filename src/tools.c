@@ -25,6 +25,7 @@
 #include <string.h>
 #include "scan.h"
 #include "tools.h"
+#include "backend.h"
 
 /*******************************************************************************
  * common typedefs && logging.
@@ -48,8 +49,9 @@ report(pList list)
     dbg("list '%s'@%p: count=%u; first=%p; last=%p\n", list->name, list, list->count, list->first, list->last);
 
     pItem p = list->first;
+    uint32_t i = 0;
     while (p != NULL) {
-        verbose("    item%.2u: prev = %p, ptr = %p: next = %p\n", p->index, p->prev, p, p->next);
+        verbose("    item%.2u: prev = %p, ptr = %p: next = %p\n", i++, p->prev, p, p->next);
         p = p->next;
     }
     dbg("--------------------------------------------------------------\n");
@@ -87,6 +89,7 @@ NewList(pList const list, char const *name)
 }
 
 // returns true, if a pointer is part of list.
+// O(n), use ItemIsLinked() if only the links are to be checked.
 bool
 IsMember(pList list, void *item)
 {
@@ -99,13 +102,23 @@ IsMember(pList list, void *item)
     return false;
 }
 
+// O(1) sanity check: true, if item was added to list and its neighbours point back to it.
+static bool
+ItemIsLinked(pList list, pItem p)
+{
+    if (p->list != list)
+        return false;
+    if (p->prev ? ((pItem)p->prev)->next != p : list->first != p)
+        return false;
+    if (p->next ? ((pItem)p->next)->prev != p : list->last != p)
+        return false;
+    return true;
+}
+
 // remove all items from list && free allocated memory.
 void
 ClearList(pList list)
 {
-    while (list->lock)
-        ;
-    list->lock = true;
     dbg("%s %d: list:'%s'\n", __FUNCTION__, __LINE__, list->name);
     pItem p = list->last;
 
@@ -119,22 +132,31 @@ ClearList(pList list)
     }
     list->first = NULL;
     list->count = 0;
-    list->lock = false;
     report(list);
 }
 
 // returns item specified by zero-based index.
+// walks the list, dont use on hot paths.
 void *
 GetItem(pList list, uint32_t index)
 {
     dbg("%s %d: list:'%s'\n", __FUNCTION__, __LINE__, list->name);
     pItem p;
-    for (p = list->first; p; p = p->next) {
-        dbg("    item%.2u: (prev=%p, p=%p, next=%p)\n", p->index, p->prev, p, p->next);
-        if (p->index == index)
-            return p;
-    }
-    return NULL;
+    for (p = list->first; p && index; p = p->next)
+        index--;
+    return p;
+}
+
+// returns zero-based index of item, or list->count if not member.
+// walks the list, for diagnostic output only.
+uint32_t
+GetIndex(pList list, void *item)
+{
+    pItem p;
+    uint32_t index = 0;
+    for (p = list->first; p && (p != item); p = p->next)
+        index++;
+    return index;
 }
 
 // append item at end of list.
@@ -142,15 +164,12 @@ void
 AddItem(pList list, void *item)
 {
     pItem p = item;
-    while (list->lock)
-        ;
-    list->lock = true;
 
     dbg("%s %d: list:'%s' add item: (prev=%p, p=%p, next=%p)\n", __FUNCTION__, __LINE__, list->name, p->prev, p, p->next);
 
-    p->index = list->count;
     p->prev = list->last;
     p->next = NULL;
+    p->list = list;
 
     if (list->count == 0) {
         list->first = p;
@@ -161,125 +180,81 @@ AddItem(pList list, void *item)
 
     list->last = item;
     list->count++;
-    list->lock = false;
     report(list);
 }
 
-// insert item to list. index is zero-based pos of new item.
-// if index greater as (list.count-1), item will be appended instead.
+// insert item in front of next, which has to be member of list.
+// if next is NULL, item will be appended instead.
 void
-InsertItem(pList list, void *item, uint32_t index)
+InsertItemBefore(pList list, void *item, void *next)
 {
-    while (list->lock)
-        ;
-    list->lock = true;
+    pItem p = item, n = next;
 
-    dbg("%s %d: list:'%s' item=%p, index=%u\n", __FUNCTION__, __LINE__, list->name, item, index);
-
-    pItem prev, next, p = item;
-    p->index = 0;
-    p->prev = NULL;
-    p->next = NULL;
+    dbg("%s %d: list:'%s' item=%p, next=%p\n", __FUNCTION__, __LINE__, list->name, item, next);
 
-    if (index >= list->count) {
-        dbg("insert at end of list.\n");
+    if (n == NULL) {
         AddItem(list, item);
-    } else if (index == 0) {
-        dbg("insert at begin of list.\n");
-        p->prev = NULL;
-        p->next = list->first;
-        p->index = 0;
-        next = list->first;
-        next->prev = p;
-        p = list->first;
-        while (p != NULL) {
-            p->index++;
-            p = p->next;
-        }
-        list->first = item;
-        list->count++;
-    } else {
-        dbg("insert somewhere in the middle.\n");
-        next = GetItem(list, index);
-        prev = next->prev;
-        prev->next = p;
-        next->prev = p;
-        p->prev = prev;
-        p->next = next;
-        p->index = prev->index;
-        list->count++;
-        while (p != NULL) {
-            p->index++;
-            p = p->next;
-        }
+        return;
     }
-    list->lock = false;
+    if (n->list != list) {
+        warning("Cannot insert item %p: %p is not member of list %s.\n", item, next, list->name);
+        return;
+    }
+    p->prev = n->prev;
+    p->next = n;
+    p->list = list;
+    if (n->prev != NULL)
+        ((pItem)n->prev)->next = p;
+    else
+        list->first = p;
+    n->prev = p;
+    list->count++;
     report(list);
 }
 
+// insert item to list. index is zero-based pos of new item.
+// if index greater as (list.count-1), item will be appended instead.
+// O(index), prefer AddItem() or InsertItemBefore().
+void
+InsertItem(pList list, void *item, uint32_t index)
+{
+    dbg("%s %d: list:'%s' item=%p, index=%u\n", __FUNCTION__, __LINE__, list->name, item, index);
+    InsertItemBefore(list, item, index ? GetItem(list, index) : list->first);
+}
+
 // remove item from list. free allocated memory if release_mem non-zero.
+// prev and next of an unlinked item are left untouched, so that a loop over the list may continue.
 void
 UnlinkItem(pList list, void *item, bool freemem)
 {
-    while (list->lock)
-        ;
-    list->lock = true;
-
-    pItem prev, next, p = item;
+    pItem p = item;
 
     dbg("%s %d: list:'%s' item=%p, freemem = %d\n", __FUNCTION__, __LINE__, list->name, item, freemem);
-    if (IsMember(list, item) == false) {
+    if ((list->count == 0) || !ItemIsLinked(list, p)) {
         warning("Cannot %s: item %p is not member of list %s.\n", freemem ? "delete" : "unlink", item, list->name);
         return;
-    } else if (item == list->first) {
-        dbg("delete at begin of list.\n");
+    }
+
+    if (p->prev != NULL)
+        ((pItem)p->prev)->next = p->next;
+    else
         list->first = p->next;
-        list->count--;
-        if (freemem) {
-            free(p);
-        }
-        p = list->first;
-        if (p != NULL)
-            p->prev = NULL;
-        while (p != NULL) {
-            p->index--;
-            p = p->next;
-        }
-    } else if (item == list->last) {
-        dbg("delete at end of list.\n");
+    if (p->next != NULL)
+        ((pItem)p->next)->prev = p->prev;
+    else
         list->last = p->prev;
-        list->count--;
-        if (freemem) {
-            free(p);
-        }
-        p = list->last;
-        if (p != NULL) {
-            p->next = NULL;
-        }
-    } else {
-        dbg("delete somewhere in the middle.\n");
-        prev = p->prev;
-        next = p->next;
-        prev->next = next;
-        next->prev = prev;
-        list->count--;
-        if (freemem) {
-            free(p);
-        }
-        p = next;
-        while (p != NULL) {
-            p->index--;
-            p = p->next;
-        }
-    }
-    list->lock = false;
+    list->count--;
+    p->list = NULL;
+    if (freemem)
+        free(p);
+    report(list);
 }
 
 // remove item from list and free allocated memory.
 void
 DeleteItem(pList list, void *item)
 {
-    dbg("%s %d: list:'%s' item=%p\n", __FUNCTION__, __LINE__, list->name, index);
+    dbg("%s %d: list:'%s' item=%p\n", __FUNCTION__, __LINE__, list->name, item);
     UnlinkItem(list, item, true);
 }
 
@@ -287,10 +262,6 @@ DeleteItem(pList list, void *item)
 void
 SwapItem(pList list, pItem a, pItem b)
 {
-    while (list->lock)
-        ;
-    list->lock = true;
-
     dbg("%s %d: list:'%s' a:(prev=%p,p=%p,next=%p) <-> b:(prev=%p,p=%p,next=%p)\n",
         __FUNCTION__,
         __LINE__,
@@ -301,58 +272,83 @@ SwapItem(pList list, pItem a, pItem b)
         b->prev,
         b,
         b->next);
-    uint32_t index_a, index_b;
-    if (a == b) {
-        list->lock = false;
+    pItem next_a;
+
+    if (a == b)
+        return;
+    if (a->next == b) {
+        UnlinkItem(list, b, false);
+        InsertItemBefore(list, b, a);
         return;
     }
-
-    index_a = a->index;
-    index_b = b->index;
-
-    if (index_a < index_b) {
-        UnlinkItem(list, b, 0);
-        UnlinkItem(list, a, 0);
-        InsertItem(list, b, index_a);
-        InsertItem(list, a, index_b);
-    } else {
-        UnlinkItem(list, a, 0);
-        UnlinkItem(list, b, 0);
-        InsertItem(list, a, index_b);
-        InsertItem(list, b, index_a);
+    if (b->next == a) {
+        UnlinkItem(list, a, false);
+        InsertItemBefore(list, a, b);
+        return;
     }
-    list->lock = false;
+    next_a = a->next;
+    UnlinkItem(list, a, false);
+    InsertItemBefore(list, a, b);
+    UnlinkItem(list, b, false);
+    InsertItemBefore(list, b, next_a);
 }
 
-// sort the list. assign sort criteria function
+// sort the list, equal items keep their order. assign sort criteria function
 // 'compare' to list before first use.
-// warning: procedure is *slow* for large lists.
+// bottom-up merge sort on the item links, O(n log n).
 void
 SortList(pList list, cmp_func compare)
 {
     dbg("%s %d: list:'%s'\n", __FUNCTION__, __LINE__, list->name);
-    pItem c, d;
+    pItem head, tail, p, q, e;
+    uint32_t width, merges, psize, qsize;
+
     if (compare == NULL) {
         warning("sort function not assigned.\n");
         return;
     }
+    if (list->count < 2)
+        return;
 
-redo:
-    c = list->first;
-    while (c != NULL) {
-        d = c;
-        while (d != NULL) {
-            if (d->next == NULL) {
-                break;
-            }
-            if (compare(d, d->next) > 0) {
-                SwapItem(list, d, d->next);
-                goto redo;
+    head = list->first;
+    for (width = 1;; width *= 2) {
+        p = head;
+        head = tail = NULL;
+        merges = 0;
+
+        while (p != NULL) {
+            // merge the runs p[0..psize) and q[0..qsize), each up to width items.
+            merges++;
+            for (q = p, psize = 0; (psize < width) && q; psize++)
+                q = q->next;
+            qsize = width;
+
+            while (psize || (qsize && q)) {
+                if ((psize == 0) || ((qsize && q) && (compare(p, q) > 0))) {
+                    e = q;
+                    q = q->next;
+                    qsize--;
+                } else {
+                    e = p;
+                    p = p->next;
+                    psize--;
+                }
+                if (tail != NULL)
+                    tail->next = e;
+                else
+                    head = e;
+                e->prev = tail;
+                tail = e;
             }
-            d = d->next;
+            p = q;
         }
-        c = c->next;
+        tail->next = NULL;
+        if (merges < 2)
+            break;
     }
+    list->first = head;
+    list->last = tail;
+    report(list);
 }
 
 void *
@@ -396,7 +392,7 @@ elapsed(struct timespec *from, struct timespec *to)
 void
 get_time(struct timespec *dest)
 {
-    clock_gettime(CLK_SPEC, dest);
+    backend->clock_gettime(CLK_SPEC, dest);
 }
 
 void
@@ -406,7 +402,7 @@ set_timeout(uint16_t msec, struct timespec *dest)
     uint32_t nsec;
     uint8_t sec;
 
-    clock_gettime(CLK_SPEC, &t);
+    backend->clock_gettime(CLK_SPEC, &t);
     sec = (t.tv_nsec + msec * 1000000U) / 1000000000U;
     nsec = (t.tv_nsec + msec * 1000000U) % 1000000000U;
     dest->tv_sec = t.tv_sec + sec;
@@ -419,7 +415,7 @@ timeout_expired(struct timespec *src)
 {
     struct timespec t;
     int expired;
-    clock_gettime(CLK_SPEC, &t);
+    backend->clock_gettime(CLK_SPEC, &t);
 
     expired = (t.tv_sec > src->tv_sec) || ((t.tv_sec == src->tv_sec) && (t.tv_nsec > src->tv_nsec));
     // dbg("now = %ld.%.9li; expired=%d\n", t.tv_sec, t.tv_nsec, expired);
@@ -1000,7 +996,7 @@ interleaver_name(int i)
 typedef struct {
     void *prev;
     void *next;
-    uint32_t index;
+    pList list;
     uint8_t value;
     uint8_t count;
 } byte_item;
@@ -1017,7 +1013,8 @@ fuzzy_section(void *s)
     struct section_buf *section = (struct section_buf *)s;
     cList current_byte;
     unsigned char *buf;
-    unsigned i, j;
+    unsigned i;
+    pItem g;
 
     if (section->garbage == NULL)
         return false;
@@ -1027,8 +1024,8 @@ fuzzy_section(void *s)
         byte_item *bi;
         NewList(&current_byte, "fuzzy_section: current_byte");
 
-        for (j = 0; j < (section->garbage)->count; j++) {
-            buf = GetItem(section->garbage, j) + sizeof(cList);
+        for (g = (section->garbage)->first; g; g = g->next) {
+            buf = (unsigned char *)g + sizeof(cList);
             for (bi = current_byte.first; bi; bi = bi->next) {
                 if (bi->value == buf[i]) {
                     bi->count++;
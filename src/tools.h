@@ -106,13 +106,12 @@ typedef struct {
     void *last;
     uint32_t count;
     char *name;
-    bool lock;
 } cList, *pList;
 
 typedef struct {
     void *prev;
     void *next;
-    uint32_t index;
+    pList list; // the list holding the item, NULL if none; see UnlinkItem().
 } cItem, *pItem;
 
 void NewList(pList const list, char const *name);
@@ -123,7 +122,9 @@ void DeleteItem(pList list, void *item);
 void SwapItem(pList list, pItem a, pItem b);
 void UnlinkItem(pList list, void *item, bool freemem);
 void InsertItem(pList list, void *item, uint32_t index);
+void InsertItemBefore(pList list, void *item, void *next);
 void *GetItem(pList list, uint32_t index);
+uint32_t GetIndex(pList list, void *item);
 bool IsMember(pList list, void *item);
 
 /*******************************************************************************
@@ -0,0 +1,321 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tp-index.h"
+
+#define FREQ_BUCKET_WIDTH 2000 // >= largest distance of is_nearly_same_frequency().
+
+struct tp_index_entry {
+    struct transponder *t;
+    uint32_t seq; // order of tp_index_add(), same as list order.
+    uint32_t pos; // position in entries[]
+    uint32_t stamp; // last query, which found this entry.
+    uint8_t list; // TP_INDEX_SCANNED or TP_INDEX_NEW
+    uint32_t id_key; // network_id << 16 | transport_stream_id
+    uint32_t ts_key; // transport_stream_id
+    uint32_t nfreq;
+    uint32_t *freq_keys; // frequency / FREQ_BUCKET_WIDTH of t and of all cell center frequencies.
+};
+
+struct bucket {
+    struct tp_index_entry **e;
+    uint32_t count;
+    uint32_t size;
+};
+
+static struct tp_index_entry **entries = NULL;
+static uint32_t entries_count = 0;
+static uint32_t entries_size = 0;
+
+static struct bucket *id_buckets = NULL;
+static struct bucket *ts_buckets = NULL;
+static struct bucket *freq_buckets = NULL;
+static uint32_t buckets_size = 0; // power of two, grows with entries_count.
+
+static uint32_t seq = 0;
+static uint32_t stamp = 0;
+
+static struct tp_index_entry **found = NULL; // candidates of the current query.
+static uint32_t found_count = 0;
+static uint32_t found_size = 0;
+
+static uint32_t
+hash(uint32_t key)
+{
+    uint32_t h = key * 0x9E3779B1U;
+    return (h ^ (h >> 16)) & (buckets_size - 1);
+}
+
+static void
+append(struct tp_index_entry ***array, uint32_t *count, uint32_t *size, struct tp_index_entry *e)
+{
+    if (*count == *size) {
+        *size = *size ? 2 * *size : 8;
+        *array = realloc(*array, *size * sizeof(struct tp_index_entry *));
+    }
+    (*array)[(*count)++] = e;
+}
+
+static void
+bucket_add(struct bucket *b, struct tp_index_entry *e)
+{
+    append(&b->e, &b->count, &b->size, e);
+}
+
+static void
+bucket_del(struct bucket *b, struct tp_index_entry *e)
+{
+    uint32_t i;
+
+    for (i = 0; i < b->count; i++) {
+        if (b->e[i] == e) {
+            b->e[i] = b->e[--b->count];
+            return;
+        }
+    }
+}
+
+static void
+set_keys(struct tp_index_entry *e)
+{
+    struct transponder *t = e->t;
+    struct cell *c;
+    uint32_t n = 1;
+    int i;
+
+    e->id_key = (t->network_id << 16) | t->transport_stream_id;
+    e->ts_key = t->transport_stream_id;
+    for (c = t->cells ? t->cells->first : NULL; c; c = c->next)
+        n += c->num_center_frequencies;
+    e->freq_keys = realloc(e->freq_keys, n * sizeof(uint32_t));
+    e->nfreq = 0;
+    e->freq_keys[e->nfreq++] = t->frequency / FREQ_BUCKET_WIDTH;
+    for (c = t->cells ? t->cells->first : NULL; c; c = c->next) {
+        for (i = 0; i < c->num_center_frequencies; i++)
+            e->freq_keys[e->nfreq++] = c->center_frequencies[i] / FREQ_BUCKET_WIDTH;
+    }
+}
+
+static void
+link_entry(struct tp_index_entry *e)
+{
+    uint32_t i;
+
+    bucket_add(&id_buckets[hash(e->id_key)], e);
+    bucket_add(&ts_buckets[hash(e->ts_key)], e);
+    for (i = 0; i < e->nfreq; i++)
+        bucket_add(&freq_buckets[hash(e->freq_keys[i])], e);
+}
+
+static void
+unlink_entry(struct tp_index_entry *e)
+{
+    uint32_t i;
+
+    bucket_del(&id_buckets[hash(e->id_key)], e);
+    bucket_del(&ts_buckets[hash(e->ts_key)], e);
+    for (i = 0; i < e->nfreq; i++)
+        bucket_del(&freq_buckets[hash(e->freq_keys[i])], e);
+}
+
+static void
+grow(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < buckets_size; i++) {
+        free(id_buckets[i].e);
+        free(ts_buckets[i].e);
+        free(freq_buckets[i].e);
+    }
+    free(id_buckets);
+    free(ts_buckets);
+    free(freq_buckets);
+    buckets_size = buckets_size ? 2 * buckets_size : 256;
+    id_buckets = calloc(buckets_size, sizeof(struct bucket));
+    ts_buckets = calloc(buckets_size, sizeof(struct bucket));
+    freq_buckets = calloc(buckets_size, sizeof(struct bucket));
+    for (i = 0; i < entries_count; i++)
+        link_entry(entries[i]);
+}
+
+void
+tp_index_add(struct transponder *t, int list)
+{
+    struct tp_index_entry *e;
+
+    tp_index_remove(t);
+    e = calloc(1, sizeof(struct tp_index_entry));
+    e->t = t;
+    e->list = list;
+    e->seq = ++seq;
+    e->pos = entries_count;
+    set_keys(e);
+    append(&entries, &entries_count, &entries_size, e);
+    t->tp_index = e;
+    if (entries_count > buckets_size)
+        grow(); // links all entries, incl. e
+    else
+        link_entry(e);
+}
+
+void
+tp_index_remove(struct transponder *t)
+{
+    struct tp_index_entry *e = t->tp_index;
+
+    if (e == NULL)
+        return;
+    unlink_entry(e);
+    entries[e->pos] = entries[--entries_count];
+    entries[e->pos]->pos = e->pos;
+    free(e->freq_keys);
+    free(e);
+    t->tp_index = NULL;
+}
+
+void
+tp_index_update(struct transponder *t)
+{
+    struct tp_index_entry *e = t->tp_index;
+
+    if (e == NULL)
+        return;
+    unlink_entry(e);
+    set_keys(e);
+    link_entry(e);
+}
+
+int
+tp_index_list(struct transponder const *t)
+{
+    return t->tp_index ? t->tp_index->list : 0;
+}
+
+enum key_type { FREQ_KEY, ID_KEY, TS_KEY };
+
+/* adds all entries in lists with key to found[], each entry only once per query. */
+static void
+collect(struct bucket *buckets, uint32_t key, enum key_type type, int lists)
+{
+    struct bucket *b = &buckets[hash(key)];
+    uint32_t i, j;
+
+    for (i = 0; i < b->count; i++) {
+        struct tp_index_entry *e = b->e[i];
+        bool hit = false;
+
+        if ((e->stamp == stamp) || !(e->list & lists))
+            continue;
+        if (type == ID_KEY)
+            hit = e->id_key == key;
+        else if (type == TS_KEY)
+            hit = e->ts_key == key;
+        else {
+            for (j = 0; (j < e->nfreq) && !hit; j++)
+                hit = e->freq_keys[j] == key;
+        }
+        if (hit) {
+            e->stamp = stamp;
+            append(&found, &found_count, &found_size, e);
+        }
+    }
+}
+
+/* list order: scanned_transponders before new_transponders, then order of adding. */
+static bool
+before(struct tp_index_entry const *a, struct tp_index_entry const *b)
+{
+    return (a->list < b->list) || ((a->list == b->list) && (a->seq < b->seq));
+}
+
+bool
+tp_index_before(struct transponder const *a, struct transponder const *b)
+{
+    return a->tp_index && b->tp_index && before(a->tp_index, b->tp_index);
+}
+
+/* sorts found[] into list order and returns the first match. */
+static struct transponder *
+first_match(tp_match_func match, void *arg)
+{
+    uint32_t i, j;
+
+    for (i = 1; i < found_count; i++) {
+        struct tp_index_entry *e = found[i];
+
+        for (j = i; (j > 0) && before(e, found[j - 1]); j--)
+            found[j] = found[j - 1];
+        found[j] = e;
+    }
+    for (i = 0; i < found_count; i++) {
+        if (match(found[i]->t, arg))
+            return found[i]->t;
+    }
+    return NULL;
+}
+
+struct transponder *
+tp_index_find_freq(uint32_t frequency, pList cells, int lists, tp_match_func match, void *arg)
+{
+    uint32_t key = frequency / FREQ_BUCKET_WIDTH;
+    struct cell *c;
+    int i;
+
+    if (buckets_size == 0)
+        return NULL;
+    stamp++;
+    found_count = 0;
+    if (key > 0)
+        collect(freq_buckets, key - 1, FREQ_KEY, lists);
+    collect(freq_buckets, key, FREQ_KEY, lists);
+    collect(freq_buckets, key + 1, FREQ_KEY, lists);
+    for (c = cells ? cells->first : NULL; c; c = c->next) {
+        for (i = 0; i < c->num_center_frequencies; i++)
+            collect(freq_buckets, c->center_frequencies[i] / FREQ_BUCKET_WIDTH, FREQ_KEY, lists);
+    }
+    return first_match(match, arg);
+}
+
+struct transponder *
+tp_index_find_id(uint16_t network_id, uint16_t transport_stream_id, int lists, tp_match_func match, void *arg)
+{
+    if (buckets_size == 0)
+        return NULL;
+    stamp++;
+    found_count = 0;
+    collect(id_buckets, (network_id << 16) | transport_stream_id, ID_KEY, lists);
+    return first_match(match, arg);
+}
+
+struct transponder *
+tp_index_find_ts(uint16_t transport_stream_id, int lists, tp_match_func match, void *arg)
+{
+    if (buckets_size == 0)
+        return NULL;
+    stamp++;
+    found_count = 0;
+    collect(ts_buckets, transport_stream_id, TS_KEY, lists);
+    return first_match(match, arg);
+}
@@ -0,0 +1,73 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#ifndef __TP_INDEX_H__
+#define __TP_INDEX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "si_types.h"
+
+/*
+ * index of all transponders in scanned_transponders and new_transponders,
+ * by (network_id, transport_stream_id), by transport_stream_id and by
+ * frequency, incl. the center frequencies of all cells. The lists stay the owners of the transponders.
+ *
+ * The index has to follow the lists: tp_index_add() after adding a transponder,
+ * tp_index_remove() before unlinking it, and tp_index_update() after changing
+ * its frequency, cells, network_id or transport_stream_id.
+ */
+
+#define TP_INDEX_SCANNED 1 // scanned_transponders
+#define TP_INDEX_NEW     2 // new_transponders
+
+/* returns true, if t is the wanted transponder. */
+typedef bool (*tp_match_func)(struct transponder *t, void *arg);
+
+void tp_index_add(struct transponder *t, int list);
+void tp_index_remove(struct transponder *t);
+void tp_index_update(struct transponder *t);
+
+/* TP_INDEX_SCANNED, TP_INDEX_NEW or 0, if t is in none of both lists. */
+int tp_index_list(struct transponder const *t);
+
+/* true, if a is in front of b in list order (scanned_transponders, then new_transponders). */
+bool tp_index_before(struct transponder const *a, struct transponder const *b);
+
+/* the first transponder in list order (scanned_transponders, then new_transponders),
+ * for which match() returns true. Only transponders within 2000 (kHz for satellite,
+ * Hz otherwise) of frequency or with a cell center frequency equal to frequency or
+ * to one of cells are tried. cells may be NULL.
+ */
+struct transponder *
+tp_index_find_freq(uint32_t frequency, pList cells, int lists, tp_match_func match, void *arg);
+
+/* same, but tries only transponders with network_id and transport_stream_id. */
+struct transponder *
+tp_index_find_id(uint16_t network_id, uint16_t transport_stream_id, int lists, tp_match_func match, void *arg);
+
+/* same, but tries all transponders with transport_stream_id, whatever their network_id is.
+ * For tables without network_id, i.e. SDT-other and BAT.
+ */
+struct transponder *
+tp_index_find_ts(uint16_t transport_stream_id, int lists, tp_match_func match, void *arg);
+
+#endif
@@ -0,0 +1,305 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ *
+ *  referred standards:
+ *    ISO/IEC 13818-1 (2.4.3 transport stream packet layer, 2.4.4 PSI sections)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/dvb/dmx.h>
+
+#include "ts-demux.h"
+#include "tools.h"
+
+/* kernel buffer for the raw TS filter; PSI/SI pids are low bitrate,
+ * but we may not be scheduled fast enough with lots of pids.
+ */
+#define TS_DEMUX_BUFFER_SIZE (TS_PACKET_SIZE * 4096)
+
+struct ts_demux *
+ts_demux_open(char const *dmx_devname)
+{
+    struct ts_demux *d = calloc(1, sizeof(struct ts_demux));
+
+    if (d == NULL)
+        return NULL;
+    if ((d->fd = open(dmx_devname, O_RDWR | O_NONBLOCK)) < 0) {
+        warning("%s: could not open demux %s.\n", __FUNCTION__, dmx_devname);
+        free(d);
+        return NULL;
+    }
+    if (ioctl(d->fd, DMX_SET_BUFFER_SIZE, TS_DEMUX_BUFFER_SIZE) < 0)
+        verbose("%s: DMX_SET_BUFFER_SIZE failed: %d %s\n", __FUNCTION__, errno, strerror(errno));
+    return d;
+}
+
+/* a demux without device, which is fed by ts_demux_feed() only, i.e. from a file. */
+struct ts_demux *
+ts_demux_alloc(void)
+{
+    struct ts_demux *d = calloc(1, sizeof(struct ts_demux));
+
+    if (d != NULL)
+        d->fd = -1;
+    return d;
+}
+
+void
+ts_demux_close(struct ts_demux *d)
+{
+    int pid;
+
+    if (d == NULL)
+        return;
+    if (d->started)
+        ioctl(d->fd, DMX_STOP);
+    if (d->fd >= 0)
+        close(d->fd);
+    for (pid = 0; pid <= TS_MAX_PID; pid++)
+        free(d->pids[pid]);
+    free(d);
+}
+
+/* start receiving ts packets of pid; returns 0 on success. */
+int
+ts_demux_add_pid(struct ts_demux *d, uint16_t pid)
+{
+    struct ts_pid *p;
+
+    if (pid > TS_MAX_PID)
+        return -1;
+    if ((p = d->pids[pid]) == NULL) {
+        if ((p = d->pids[pid] = calloc(1, sizeof(struct ts_pid))) == NULL)
+            return -1;
+    }
+    if (p->users++ > 0)
+        return 0;
+
+    p->continuity = -1;
+    p->collecting = false;
+    p->length = 0;
+
+    if (d->fd < 0) {
+        d->active_pids++;
+        return 0;
+    }
+    if (!d->started) {
+        /* (re-)setting the filter flushes old data from the kernel buffer,
+         * which may be left from the previous transponder.
+         */
+        struct dmx_pes_filter_params f;
+
+        memset(&f, 0, sizeof(f));
+        f.pid = pid;
+        f.input = DMX_IN_FRONTEND;
+        f.output = DMX_OUT_TSDEMUX_TAP;
+        f.pes_type = DMX_PES_OTHER;
+        f.flags = DMX_IMMEDIATE_START;
+        if (ioctl(d->fd, DMX_SET_PES_FILTER, &f) < 0) {
+            errorn("ioctl DMX_SET_PES_FILTER failed");
+            p->users--;
+            return -1;
+        }
+        d->started = true;
+        d->fill = 0;
+    } else if (ioctl(d->fd, DMX_ADD_PID, &pid) < 0) {
+        errorn("ioctl DMX_ADD_PID failed");
+        p->users--;
+        return -1;
+    }
+    d->active_pids++;
+    return 0;
+}
+
+void
+ts_demux_remove_pid(struct ts_demux *d, uint16_t pid)
+{
+    struct ts_pid *p = pid <= TS_MAX_PID ? d->pids[pid] : NULL;
+
+    if ((p == NULL) || (p->users == 0) || (--p->users > 0))
+        return;
+
+    p->collecting = false;
+    if (--d->active_pids == 0) {
+        if (d->started)
+            ioctl(d->fd, DMX_STOP);
+        d->started = false;
+    } else if ((d->fd >= 0) && (ioctl(d->fd, DMX_REMOVE_PID, &pid) < 0))
+        errorn("ioctl DMX_REMOVE_PID failed");
+}
+
+#define SECTION_LENGTH(b) (((b[1] & 0x0F) << 8) | b[2])
+
+/* append len bytes of payload to the section(s) of pid; calls cb for each completed section. */
+static void
+ts_collect(struct ts_pid *p, uint16_t pid, unsigned char const *data, int len, ts_section_cb cb)
+{
+    while ((len > 0) && p->collecting && p->users) {
+        int n, total = 3; // table_id + section_length
+
+        if (p->length >= 3)
+            total += SECTION_LENGTH(p->section);
+        n = total - p->length;
+        if (n > len)
+            n = len;
+        memcpy(p->section + p->length, data, n);
+        p->length += n;
+        data += n;
+        len -= n;
+        if (p->length < total)
+            continue;
+
+        if (p->length == 3) {
+            total += SECTION_LENGTH(p->section);
+            if (total > SECTION_BUF_SIZE) {
+                verbose("%s: pid %u: section_length %d too large.\n", __FUNCTION__, pid, total - 3);
+                p->collecting = false;
+                return;
+            }
+            if (total > 3)
+                continue;
+        }
+        p->length = 0;
+        cb(pid, p->section, total);
+        // next section may follow immediately, otherwise stuffing up to end of packet.
+        if ((len > 0) && (*data == 0xFF))
+            p->collecting = false;
+    }
+}
+
+static void
+ts_packet(struct ts_demux *d, unsigned char const *pkt, ts_section_cb cb)
+{
+    uint16_t pid = ((pkt[1] & 0x1F) << 8) | pkt[2];
+    struct ts_pid *p = d->pids[pid];
+    unsigned char const *payload = pkt + 4;
+    unsigned char const *end = pkt + TS_PACKET_SIZE;
+    int8_t continuity = pkt[3] & 0x0F;
+
+    if ((p == NULL) || (p->users == 0))
+        return;
+    if (pkt[1] & 0x80) { // transport_error_indicator
+        p->collecting = false;
+        return;
+    }
+    if ((pkt[3] & 0x10) == 0) // no payload
+        return;
+    if (p->continuity >= 0) {
+        if (continuity == p->continuity) // duplicate packet
+            return;
+        if (continuity != ((p->continuity + 1) & 0x0F))
+            p->collecting = false; // lost packet(s), drop incomplete section.
+    }
+    p->continuity = continuity;
+    if (pkt[3] & 0x20) // adaptation_field
+        payload += 1 + payload[0];
+    if (payload >= end)
+        return;
+
+    if (pkt[1] & 0x40) { // payload_unit_start_indicator
+        int pointer_field = *payload++;
+
+        if (payload + pointer_field >= end) {
+            p->collecting = false;
+            return;
+        }
+        if (p->collecting && p->length)
+            ts_collect(p, pid, payload, pointer_field, cb);
+        payload += pointer_field;
+        if (*payload == 0xFF) {
+            p->collecting = false;
+            return;
+        }
+        p->collecting = true;
+        p->length = 0;
+    }
+    ts_collect(p, pid, payload, end - payload, cb);
+}
+
+/* feed len bytes of transport stream, which doesn't need to start or end on packet boundaries. */
+void
+ts_demux_feed(struct ts_demux *d, unsigned char const *buf, size_t len, ts_section_cb cb)
+{
+    while (len > 0) {
+        if (d->fill > 0) {
+            size_t n = TS_PACKET_SIZE - d->fill;
+
+            if (n > len)
+                n = len;
+            memmove(d->buf + d->fill, buf, n);
+            d->fill += n;
+            buf += n;
+            len -= n;
+            if (d->fill < TS_PACKET_SIZE)
+                return;
+            d->fill = 0;
+            ts_packet(d, d->buf, cb);
+            continue;
+        }
+        if (*buf != TS_SYNC_BYTE) { // resync
+            buf++;
+            len--;
+            continue;
+        }
+        if (len < TS_PACKET_SIZE) {
+            memmove(d->buf, buf, len);
+            d->fill = len;
+            return;
+        }
+        ts_packet(d, buf, cb);
+        buf += TS_PACKET_SIZE;
+        len -= TS_PACKET_SIZE;
+    }
+}
+
+/* read all available packets from the raw TS filter.
+ * returns -1 on error, 0 otherwise.
+ */
+int
+ts_demux_read(struct ts_demux *d, ts_section_cb cb)
+{
+    unsigned char *buf = d->buf + TS_PACKET_SIZE; // d->buf[0..187] holds incomplete packets.
+    ssize_t count = read(d->fd, buf, sizeof(d->buf) - TS_PACKET_SIZE);
+
+    if (count < 0) {
+        if (errno == EOVERFLOW) {
+            int pid;
+
+            verbose("%s: buffer overflow, dropping incomplete sections.\n", __FUNCTION__);
+            for (pid = 0; pid <= TS_MAX_PID; pid++) {
+                if (d->pids[pid])
+                    d->pids[pid]->collecting = false;
+            }
+            return 0;
+        }
+        if ((errno == EAGAIN) || (errno == EINTR))
+            return 0;
+        errorn("read error");
+        return -1;
+    }
+    ts_demux_feed(d, buf, count, cb);
+    return 0;
+}
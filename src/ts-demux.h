@@ -0,0 +1,68 @@
+/*
+ * Simple MPEG/DVB parser to achieve network/service information without initial tuning data
+ *
+ * Copyright (C) 2026 w_scan2 contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ * Or, point your browser to http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ */
+
+#ifndef __TS_DEMUX_H__
+#define __TS_DEMUX_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "si_types.h"
+
+/*
+ * userspace section demultiplexer: one raw TS filter (DMX_OUT_TSDEMUX_TAP) on the
+ * demux device for all wanted PIDs, PSI/SI sections are reassembled from the TS packets
+ * here instead of using one kernel section filter per table.
+ */
+
+#define TS_PACKET_SIZE 188
+#define TS_SYNC_BYTE   0x47
+#define TS_MAX_PID     0x1FFF
+
+/* called for every complete section on a wanted pid. CRC is not checked here. */
+typedef void (*ts_section_cb)(uint16_t pid, unsigned char const *section, int length);
+
+struct ts_pid {
+    uint16_t users; // number of add_pid() calls w/o remove_pid()
+    int8_t continuity; // last continuity_counter, -1 == none yet.
+    bool collecting; // true, if inside a section.
+    uint16_t length; // bytes collected in section.
+    unsigned char section[SECTION_BUF_SIZE];
+};
+
+struct ts_demux {
+    int fd;
+    bool started; // pes filter set and running.
+    uint16_t active_pids; // number of pids with users > 0
+    struct ts_pid *pids[TS_MAX_PID + 1];
+    size_t fill; // bytes of an incomplete packet at start of buf.
+    unsigned char buf[TS_PACKET_SIZE * 348];
+};
+
+struct ts_demux *ts_demux_open(char const *dmx_devname);
+struct ts_demux *ts_demux_alloc(void);
+void ts_demux_close(struct ts_demux *d);
+int ts_demux_add_pid(struct ts_demux *d, uint16_t pid);
+void ts_demux_remove_pid(struct ts_demux *d, uint16_t pid);
+int ts_demux_read(struct ts_demux *d, ts_section_cb cb);
+void ts_demux_feed(struct ts_demux *d, unsigned char const *buf, size_t len, ts_section_cb cb);
+
+#endif